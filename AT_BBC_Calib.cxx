@@ -0,0 +1,288 @@
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <unistd.h>
+#include <TString.h>
+#include <TMath.h>
+
+#include "Analysis.h"
+#include "EPCorrection.h"
+#include "AT_BBC_Calib.h"
+
+AT_BBC_Calib::RunCache::RunCache() {
+  for(int i=0; i!=2*6*2*60*40; ++i) {
+    (&sum[0][0][0][0][0])[i] = 0;
+    (&ent[0][0][0][0][0])[i] = 0;
+  }
+  spill = NULL;
+  nspill = 0;
+}
+
+AT_BBC_Calib::RunCache::~RunCache() {
+  if(spill) fclose(spill);
+}
+
+AT_BBC_Calib::AT_BBC_Calib() : AT_ReadTree() {
+  fTableDir = "BBC_EPC/tables";
+  fSpillDir = ".";
+  fRun = -1;
+  fMaster = NULL;
+}
+
+AnalysisTask* AT_BBC_Calib::CloneTask() const {
+  AT_BBC_Calib *cln = new AT_BBC_Calib(*this);
+  cln->fMaster = this;
+  cln->fClones.clear();
+  fClones.push_back(cln);
+  return cln;
+}
+
+AT_BBC_Calib::~AT_BBC_Calib() {
+  for(std::map<int,RunCache*>::iterator it=fRuns.begin(); it!=fRuns.end(); ++it)
+    delete it->second;
+}
+
+void AT_BBC_Calib::MyBranches(std::vector<TString> &brs) {
+  brs.push_back("Q1bb");
+  brs.push_back("Q2bb");
+  brs.push_back("Q3bb");
+  brs.push_back("Q4bb");
+  brs.push_back("Q6bb");
+  brs.push_back("Q8bb");
+}
+
+void AT_BBC_Calib::MyInit() {
+  // the first run does not come through InitRun
+  fRun = Analysis::Instance()->RunNumber();
+}
+
+void AT_BBC_Calib::InitRun(int run) {
+  AT_ReadTree::InitRun(run);
+  fRun = run;
+}
+
+void AT_BBC_Calib::MyExec() {
+  int bvtx = BinVertex( fGLB.vtxZ );
+  int bcen = BinCentrality( fGLB.cent );
+  qcQ qvec[6][2];
+  for(int se=0; se!=2; ++se) {
+    qvec[0][se] = pQ1bb->at(se);
+    qvec[1][se] = pQ2bb->at(se);
+    qvec[2][se] = pQ3bb->at(se);
+    qvec[3][se] = pQ4bb->at(se);
+    qvec[4][se] = pQ6bb->at(se);
+    qvec[5][se] = pQ8bb->at(se);
+    if(qvec[0][se].M()<1) return;
+  }
+  RunCache *&rc = fRuns[fRun];
+  if(!rc) rc = new RunCache();
+
+  // ======= raw centroids, as the BBCQ%d%c_S%d_CB%02d histograms =======
+  for(int j=0; j!=2; ++j) { // subevent
+    for(int k=0; k!=6; ++k) { //order
+      double q[2] = {qvec[k][j].X(), qvec[k][j].Y()};
+      for(int xy=0; xy!=2; ++xy) {
+	if(q[xy]<-50 || q[xy]>=+50) continue;
+	rc->sum[j][k][xy][bcen][bvtx] += q[xy];
+	rc->ent[j][k][xy][bcen][bvtx] += 1;
+      }
+    }
+  }
+
+  Event ev;
+  ev.bcen = bcen;
+  ev.bvtx = bvtx;
+  for(int k=0; k!=4; ++k) { //order
+    for(int j=0; j!=2; ++j) { // subevent
+      ev.q[k][j][0] = qvec[k][j].X();
+      ev.q[k][j][1] = qvec[k][j].Y();
+      ev.q[k][j][2] = qvec[k][j].NP();
+      ev.q[k][j][3] = qvec[k][j].M();
+    }
+  }
+  rc->events.push_back(ev);
+  if(rc->events.size()==kBlock) Spill(rc);
+}
+
+void AT_BBC_Calib::Spill(RunCache *rc) {
+  if(!rc->spill) {
+    // unlinked at once, the file goes away with the job
+    TString name = fSpillDir + "/bbccalib_XXXXXX";
+    std::vector<char> path(name.Data(),name.Data()+name.Length()+1);
+    int fd = mkstemp(&path[0]);
+    if(fd>=0) {
+      unlink(&path[0]);
+      rc->spill = fdopen(fd,"w+b");
+    }
+  }
+  if(!rc->spill ||
+     fwrite(&rc->events[0],sizeof(Event),rc->events.size(),rc->spill)!=rc->events.size()) {
+    std::cout << "AT_BBC_Calib::Spill === cannot write the event cache into " << fSpillDir.Data() << std::endl;
+    std::exit(1);
+  }
+  rc->nspill += rc->events.size();
+  rc->events.clear();
+}
+
+void AT_BBC_Calib::MyFinish() {
+  if(fMaster) return; // calibrated by the original, with this cache
+  // caches of a run from every slot; slots hold consecutive ranges
+  std::map<int,std::vector<RunCache*> > runs;
+  for(std::map<int,RunCache*>::iterator it=fRuns.begin(); it!=fRuns.end(); ++it)
+    runs[it->first].push_back(it->second);
+  for(uint i=0; i!=fClones.size(); ++i)
+    for(std::map<int,RunCache*>::iterator it=fClones[i]->fRuns.begin(); it!=fClones[i]->fRuns.end(); ++it)
+      runs[it->first].push_back(it->second);
+  for(std::map<int,std::vector<RunCache*> >::iterator it=runs.begin(); it!=runs.end(); ++it)
+    Calibrate(it->first,it->second);
+}
+
+void AT_BBC_Calib::Accumulate(const Event *ev, long n, const std::vector<EPCell> &cells, SUMS &s) {
+  const int ncell = EPCalib::kNCen*EPCalib::kNVtx;
+  double cosn[Harmonics::kN], sinn[Harmonics::kN];
+  for(long ie=0; ie!=n; ++ie) {
+    int cell = ev[ie].bcen*40+ev[ie].bvtx;
+    EPCorrection<EPCell,2> epc;
+    for(int k=0; k!=4; ++k)
+      for(int j=0; j!=2; ++j)
+	epc.Load(k,j,ev[ie].q[k][j][0],ev[ie].q[k][j][1],ev[ie].q[k][j][2],ev[ie].q[k][j][3]);
+    epc.Correct(cells[cell]);
+    for(int k=0; k!=4; ++k) { // order
+      int bin = k*ncell+cell;
+      double res = TMath::Cos( (k+1)*(epc.Sub(k,0).Psi2Pi()-epc.Sub(k,1).Psi2Pi()) );
+      s.rn[bin] += 1;
+      s.rs[bin] += res;
+      s.rs2[bin] += res*res;
+      Harmonics::CosSin(epc.Full(k).Psi2Pi(),cosn,sinn);
+      s.fn[bin] += 1;
+      for(int ik=0; ik!=Harmonics::kN; ++ik) {
+	s.fc[bin*Harmonics::kN+ik] += cosn[ik];
+	s.fs[bin*Harmonics::kN+ik] += sinn[ik];
+      }
+    }
+  }
+}
+
+void AT_BBC_Calib::Calibrate(int run, const std::vector<RunCache*> &rcs) {
+  // centroid sums of all slots into the first cache
+  RunCache *rc = rcs[0];
+  long nev = 0;
+  for(uint p=0; p!=rcs.size(); ++p) {
+    nev += rcs[p]->nspill + rcs[p]->events.size();
+    if(p==0) continue;
+    for(int i=0; i!=2*6*2*60*40; ++i) {
+      (&rc->sum[0][0][0][0][0])[i] += (&rcs[p]->sum[0][0][0][0][0])[i];
+      (&rc->ent[0][0][0][0][0])[i] += (&rcs[p]->ent[0][0][0][0][0])[i];
+    }
+  }
+  std::cout << "AT_BBC_Calib::Calibrate === run " << run << " with " << nev << " events" << std::endl;
+  const int ncell = EPCalib::kNCen*EPCalib::kNVtx;
+
+  // ======= PASS 1: Recentering (bins with less than 100 entries stay 0) =======
+  std::vector<EPCell> cells(ncell,EPCell());
+  for(int se=0; se!=2; ++se)
+    for(int ord=0; ord!=6; ++ord)
+      for(int xy=0; xy!=2; ++xy)
+	for(int i=0; i!=60; ++i)
+	  for(int j=0; j!=40; ++j)
+	    if(rc->ent[se][ord][xy][i][j]>=100)
+	      cells[i*40+j].m[se][ord][xy] = rc->sum[se][ord][xy][i][j]/rc->ent[se][ord][xy][i][j];
+
+  // ======= PASS 2: Correcting the cached events, Flattening and Resolution sums =======
+  SUMS acc;
+  acc.fn.assign(4*ncell,0.0);
+  acc.fc.assign(4*ncell*Harmonics::kN,0.0);
+  acc.fs.assign(4*ncell*Harmonics::kN,0.0);
+  acc.rn.assign(4*ncell,0.0);
+  acc.rs.assign(4*ncell,0.0);
+  acc.rs2.assign(4*ncell,0.0);
+  std::vector<Event> block;
+  for(uint p=0; p!=rcs.size(); ++p) {
+    // spilled events are the older ones
+    if(rcs[p]->spill) {
+      block.resize(kBlock);
+      rewind(rcs[p]->spill);
+      for(long done=0; done<rcs[p]->nspill; done+=kBlock) {
+	long n = fread(&block[0],sizeof(Event),kBlock,rcs[p]->spill);
+	if(n!=kBlock) {
+	  std::cout << "AT_BBC_Calib::Calibrate === event cache of run " << run << " unreadable" << std::endl;
+	  std::exit(1);
+	}
+	Accumulate(&block[0],n,cells,acc);
+      }
+    }
+    if(rcs[p]->events.size()>0)
+      Accumulate(&rcs[p]->events[0],rcs[p]->events.size(),cells,acc);
+  }
+  const std::vector<double> &fn = acc.fn, &fc = acc.fc, &fs = acc.fs;
+  const std::vector<double> &rn = acc.rn, &rs = acc.rs, &rs2 = acc.rs2;
+
+  // ======= Tables, in the layout of qcent.C, coef.C and res.C =======
+  std::ofstream fout( Form("%s/BBC_%d.dat",fTableDir.Data(),run) );
+  for(int ord=0; ord!=6; ++ord) {
+    for(int xy=0; xy!=2; ++xy) {
+      for(int se=0; se!=2; ++se) {
+	for(int i=0; i!=60; ++i) {
+	  for(int j=0; j!=40; ++j)
+	    fout << Form(" %.7g", cells[i*40+j].m[se][ord][xy]*10);
+	  fout << std::endl;
+	}
+	fout << std::endl;
+      }
+    }
+  }
+  fout.close();
+  fout.open( Form("%s/BBC_A_%d.dat",fTableDir.Data(),run) );
+  for(int ord=0; ord!=4; ++ord) {
+    for(int i=0; i!=60; ++i) {
+      for(int cs=0; cs!=2; ++cs) {
+	const std::vector<double> &sums = cs==0 ? fc : fs;
+	for(int in=0; in!=Harmonics::kN; ++in) {
+	  for(int j=0; j!=40; ++j) {
+	    int bin = ord*ncell+i*40+j;
+	    double coe = fn[bin]>0 ? sums[bin*Harmonics::kN+in]/fn[bin] : 0.0;
+	    fout << Form(" %.7g", coe*1e+3);
+	  }
+	  fout << std::endl;
+	}
+	fout << std::endl;
+      }
+    }
+  }
+  fout.close();
+  fout.open( Form("%s/BBC_R_%d.dat",fTableDir.Data(),run) );
+  for(int ord=0; ord!=4; ++ord) {
+    for(int i=0; i!=60; ++i) {
+      // [0]+[1]*(x-20) over vertex bins 11-29, least squares weighted by
+      // the error of each bin mean. res.C fits the BBCRes profiles with a
+      // log-likelihood ("RL") instead; in well filled cells the two agree
+      // well inside the quoted errors, in sparse (peripheral) cells they
+      // can move apart by about one error, and the errors are not the same
+      double s=0, sx=0, sxx=0, sy=0, sxy=0;
+      for(int j=11; j!=30; ++j) {
+	int bin = ord*ncell+i*40+j;
+	if(rn[bin]<2) continue;
+	double mean = rs[bin]/rn[bin];
+	double var = (rs2[bin]/rn[bin] - mean*mean)/rn[bin];
+	if(var<=0) continue;
+	double w = 1.0/var;
+	double x = j-20;
+	s += w;
+	sx += w*x;
+	sxx += w*x*x;
+	sy += w*mean;
+	sxy += w*x*mean;
+      }
+      double det = s*sxx - sx*sx;
+      if(det<=0) {
+	fout << 0 << " " << 0 << " " << 0 << " " << 0 << std::endl;
+	continue;
+      }
+      fout << (sxx*sy-sx*sxy)/det << " " << TMath::Sqrt(sxx/det) << " ";
+      fout << (s*sxy-sx*sy)/det << " " << TMath::Sqrt(s/det) << std::endl;
+    }
+    fout << std::endl;
+  }
+  fout.close();
+  std::cout << "   tables written into " << fTableDir.Data() << std::endl;
+}
@@ -0,0 +1,68 @@
+#ifndef __AT_BBC_CALIB_HH__
+#define __AT_BBC_CALIB_HH__
+
+#include <cstdio>
+#include <map>
+#include <vector>
+#include "AT_ReadTree.h"
+
+// BBC event-plane calibration of every run in the input, in one job.
+// The raw centroids are summed while the tree is read, and the Q vectors
+// and bins each event needs afterwards are kept in memory. Finish then
+// corrects the cached events with those centroids, takes the flattening
+// coefficients and the resolution from them, and writes the BBC_, BBC_A_
+// and BBC_R_ tables of each run (what qcent.C, coef.C and res.C make from
+// two Run_BBC_EPC passes and hadd). Each thread caches the events of its
+// own range; the task the others were cloned from calibrates every run
+// with all caches, in entry order. A run keeps at most kBlock events in
+// memory, older ones are spilled to a file in the spill directory.
+class AT_BBC_Calib : public AT_ReadTree {
+ public:
+  AT_BBC_Calib();
+  virtual ~AT_BBC_Calib();
+  virtual AnalysisTask* CloneTask() const;
+  virtual bool CanCheckpoint() const {return false;}
+  virtual void InitRun(int run);
+  virtual void MyBranches(std::vector<TString> &brs);
+  virtual void MyInit();
+  virtual void MyExec();
+  virtual void MyFinish();
+  void TableDirectory(TString dir) {fTableDir=dir;}
+  void SpillDirectory(TString dir) {fSpillDir=dir;}
+
+ private:
+  // what the second pass needs of one event: orders 1-4 of both
+  // sub-events (x y np m)
+  struct Event {
+    unsigned char bcen;
+    unsigned char bvtx;
+    float q[4][2][4];
+  };
+  enum {kBlock=1<<18}; // events of a run in memory, about 34 MB
+  struct RunCache {
+    RunCache();
+    ~RunCache();
+    double sum[2][6][2][60][40]; //se ord xy bcen bvtx, within the
+    double ent[2][6][2][60][40]; //range of the qcent.C histograms
+    std::vector<Event> events; // newest
+    FILE *spill; // older ones, kBlock at a time
+    long nspill;
+  };
+  // what pass 2 adds up, per (ord cell) bin
+  struct SUMS {
+    std::vector<double> fn, fc, fs; // flattening
+    std::vector<double> rn, rs, rs2; // resolution
+  };
+  void Spill(RunCache *rc);
+  void Accumulate(const Event *ev, long n, const std::vector<EPCell> &cells, SUMS &s);
+  void Calibrate(int run, const std::vector<RunCache*> &rcs);
+
+  TString fTableDir;
+  TString fSpillDir;
+  int fRun;
+  std::map<int,RunCache*> fRuns;
+  const AT_BBC_Calib *fMaster; // task this one was cloned from
+  mutable std::vector<AT_BBC_Calib*> fClones; // in slot order
+};
+
+#endif
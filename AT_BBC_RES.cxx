@@ -34,6 +34,7 @@ void AT_BBC_RES::MyExec() {
   float cen = fGLB.cent;
   int bvtx = BinVertex( vtx );
   int bcen = BinCentrality( cen );
+  const EPCell &cell = fCalib->Cell(bcen,bvtx);
 
   if(fQ[0]M()<1) return;
 
@@ -50,8 +51,8 @@ void AT_BBC_RES::MyExec() {
     for(int j=0; j!=2; ++j) { // subevent
       double x = qvec[k][j].X();
       double y = qvec[k][j].Y();
-      double cn = bbcm[j][k][0][bcen][bvtx];
-      double sn = bbcm[j][k][1][bcen][bvtx];
+      double cn = cell.m[j][k][0];
+      double sn = cell.m[j][k][1];
       qvec[k][j].SetXY( x - cn, y - sn, qvec[k][j].NP(), qvec[k][j].M() );
     }
   }
@@ -70,8 +71,8 @@ void AT_BBC_RES::MyExec() {
     for(int j=0; j!=2; ++j) { // subevent
       double x = qvec[k][j].X();
       double y = qvec[k][j].Y();
-      double c2n = bbcm[j][twon[k]][0][bcen][bvtx] / qvec[k][j].M();
-      double s2n = bbcm[j][twon[k]][1][bcen][bvtx] / qvec[k][j].M();
+      double c2n = cell.m[j][twon[k]][0] / qvec[k][j].M();
+      double s2n = cell.m[j][twon[k]][1] / qvec[k][j].M();
       double ldaSm = s2n/(1.0+c2n);
       double ldaSp = s2n/(1.0-c2n);
       double den = 1.0 - ldaSm*ldaSp;
@@ -104,7 +105,7 @@ void AT_BBC_RES::MyExec() {
     for(int j=0; j!=2; ++j) { // subevent
       double x = qvec[k][j].X();
       double y = qvec[k][j].Y();
-      double c2n = bbcm[j][twon[k]][0][bcen][bvtx] / qvec[k][j].M();
+      double c2n = cell.m[j][twon[k]][0] / qvec[k][j].M();
       double a2np = 1.0+c2n;
       double a2nm = 1.0-c2n;
       qvec[k][j].SetXY( x / a2np,
@@ -139,8 +140,8 @@ void AT_BBC_RES::MyExec() {
     for(int ik=0; ik!=32; ++ik) { // correction order
       int nn = ik+1;
       double prime = 0.0;
-      prime += TMath::Cos(nn*psi)*bbcc[ik][k][bcen][bvtx]*2.0/nn;
-      prime += TMath::Sin(nn*psi)*bbcs[ik][k][bcen][bvtx]*2.0/nn;
+      prime += TMath::Cos(nn*psi)*cell.c[k][ik]*2.0/nn;
+      prime += TMath::Sin(nn*psi)*cell.s[k][ik]*2.0/nn;
       hDeltaPsi[k][bcen]->Fill(ik, prime);
     }
   }
@@ -11,6 +11,8 @@ class AT_Charged : public AT_ReadTree {
  public:
   AT_Charged();
   virtual ~AT_Charged();
+  virtual AnalysisTask* CloneTask() const {return new AT_Charged(*this);}
+  virtual void MyBranches(std::vector<TString> &brs);
   virtual void MyInit();
   virtual void MyExec();
   virtual void MyFinish();
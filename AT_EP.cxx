@@ -3,6 +3,8 @@
 #include <TMath.h>
 #include <TH1F.h>
 #include <TProfile.h>
+#include <TArrayD.h>
+#include <TDirectory.h>
 #include "Analysis.h"
 #include "AT_EP.h"
 
@@ -22,6 +24,16 @@ AT_EP::AT_EP() {
 		      0.120, 0.130, 0.140, 0.150, 0.160,
 		      0.170, 0.180, 0.200, 0.220, 0.240, 0.260};
   for(int i=0; i!=fNma+1; ++i) fMassBins[i] = mabins[i];
+  // cells no wider than the narrowest pt bin hold at most one edge
+  fPtStep = fPtBins[fNpt]-fPtBins[0];
+  for(int i=0; i!=fNpt; ++i)
+    fPtStep = TMath::Min( fPtStep, fPtBins[i+1]-fPtBins[i] );
+  int ncell = int((fPtBins[fNpt]-fPtBins[0])/fPtStep)+1;
+  fPtLUT.resize(ncell);
+  for(int c=0, p=0; c!=ncell; ++c) {
+    while(p+1<fNpt && fPtBins[p+1]<=fPtBins[0]+c*fPtStep) ++p;
+    fPtLUT[c] = p;
+  }
 }
 
 AT_EP::~AT_EP() {
@@ -32,111 +44,169 @@ void AT_EP::Init() {
   fCandidates = ana->GetCandidates();
   fCandidates2 = ana->GetCandidates2();
   for(int i=0; i!=4; ++i) fQ[i] = ana->GetQ(i);
-  TProfile *fPQ_Cos[4];
-  hEta = new TH1F("hEta","hEta",100,-1,+1);
-  hEta2 = new TH1F("hEta2","hEta2",100,-1,+1);
-  for(int p=0; p!=fNpt; ++p) {
-    hMass[p] = new TH1F( Form("hMass_PB%d",p),
-			 Form("hMass_PB%d;Mass",p),
-			 240,//220, //assuming 0.260-0.040 = 0.220
-			 fMassBins[0],fMassBins[fNma] );
-    hMass2[p] = new TH1F( Form("hMass2_PB%d",p),
-			  Form("hMass2_PB%d;Mass",p),
-			  240,//220, //assuming 0.260-0.040 = 0.220
-			  fMassBins[0],fMassBins[fNma] );
-    for(int n=0; n!=5; ++n) {
-      hCos[n][p] = new TProfile( Form("hCos%dDP_PB%d",n,p),
-				 Form("hCos%dDP_PB%d;Mass",n,p), 
-				 120,//110,
-				 fMassBins[0],fMassBins[fNma] );
-      hCos2[n][p] = new TProfile( Form("hCos2%dDP_PB%d",n,p),
-				  Form("hCos2%dDP_PB%d;Mass",n,p), 
-				  120,//110,
-				  fMassBins[0],fMassBins[fNma] );
-      //				 fNma, fMassBins );
+  fCutNames = *(ana->GetCandidateCutNames());
+  if(fCutNames.size()==0) fCutNames.push_back("");
+  fHistos.resize( fCutNames.size() );
+  for(uint v=0; v!=fHistos.size(); ++v) {
+    EPHISTOS &h = fHistos[v];
+    h.hEta = new TH1F("hEta","hEta",100,-1,+1);
+    h.hEta2 = new TH1F("hEta2","hEta2",100,-1,+1);
+    for(int p=0; p!=fNpt; ++p) {
+      h.hMass[p] = new TH1F( Form("hMass_PB%d",p),
+			     Form("hMass_PB%d;Mass",p),
+			     240,//220, //assuming 0.260-0.040 = 0.220
+			     fMassBins[0],fMassBins[fNma] );
+      h.hMass2[p] = new TH1F( Form("hMass2_PB%d",p),
+			      Form("hMass2_PB%d;Mass",p),
+			      240,//220, //assuming 0.260-0.040 = 0.220
+			      fMassBins[0],fMassBins[fNma] );
+      for(int n=0; n!=5; ++n) {
+	h.hCos[n][p] = new TProfile( Form("hCos%dDP_PB%d",n,p),
+				     Form("hCos%dDP_PB%d;Mass",n,p), 
+				     kNProf,//110,
+				     fMassBins[0],fMassBins[fNma] );
+	h.hCos2[n][p] = new TProfile( Form("hCos2%dDP_PB%d",n,p),
+				      Form("hCos2%dDP_PB%d;Mass",n,p), 
+				      kNProf,//110,
+				      fMassBins[0],fMassBins[fNma] );
+	//				 fNma, fMassBins );
+      }
     }
   }
+  int ncell = fNpt*(kNProf+2);
+  fAcc.resize( 2*fHistos.size() );
+  for(uint a=0; a!=fAcc.size(); ++a) {
+    fAcc[a].n.assign(ncell,0.0);
+    fAcc[a].sum.assign(ncell*kNCos,0.0);
+    fAcc[a].sum2.assign(ncell*kNCos,0.0);
+  }
 }
 
 void AT_EP::Finish() {
-  hEta->Write();
-  hEta2->Write();
-  for(int p=0; p!=fNpt; ++p) {
-    hMass[p]->Write();
-    hMass2[p]->Write();
-    for(int n=0; n!=5; ++n) {
-      hCos[n][p]->Write();
-      hCos2[n][p]->Write();
+  // nominal at the top, each variation in a directory of its own name
+  TDirectory *top = gDirectory;
+  for(uint v=0; v!=fHistos.size(); ++v) {
+    if(v>0) top->mkdir( fCutNames[v].Data() )->cd();
+    EPHISTOS &h = fHistos[v];
+    for(int mixed=0; mixed!=2; ++mixed) {
+      const FLOWACC &acc = fAcc[v*2+mixed];
+      for(int p=0; p!=fNpt; ++p) {
+	for(int n=0; n!=kNCos; ++n) {
+	  // profiles are set, not added to: Finish may run more than once
+	  TProfile *prof = mixed ? h.hCos2[n][p] : h.hCos[n][p];
+	  prof->Reset();
+	  double *sum = prof->GetArray();
+	  double *sum2 = prof->GetSumw2()->GetArray();
+	  TArrayD *binw2 = prof->GetBinSumw2();
+	  double entries = 0;
+	  for(int b=0; b!=kNProf+2; ++b) {
+	    int cell = p*(kNProf+2)+b;
+	    sum[b] = acc.sum[cell*kNCos+n];
+	    sum2[b] = acc.sum2[cell*kNCos+n];
+	    prof->SetBinEntries( b, acc.n[cell] );
+	    if(binw2->GetSize()) binw2->GetArray()[b] = acc.n[cell];
+	    entries += acc.n[cell];
+	  }
+	  prof->SetEntries( entries );
+	  prof->ResetStats();
+	}
+      }
     }
+    h.hEta->Write();
+    h.hEta2->Write();
+    for(int p=0; p!=fNpt; ++p) {
+      h.hMass[p]->Write();
+      h.hMass2[p]->Write();
+      for(int n=0; n!=5; ++n) {
+	h.hCos[n][p]->Write();
+	h.hCos2[n][p]->Write();
+      }
+    }
+    top->cd();
   }
 }
 
 void AT_EP::Exec() {
   if(fQ[0]->M()<1) return;
-
-  // CANDIDATES 1
-  uint npa = fCandidates->size();
-  for(int i=0; i!=npa; ++i) {
-    TLorentzVector a = fCandidates->at(i);
-    double ma = a.M();
-    double pt = a.Pt();
-    int mb = BinMass( ma );
-    int pb = BinPt( pt );
-    if(mb<0||pb<0) continue;
-    /// recording
-    hEta->Fill( a.Eta() );
-    hMass[pb]->Fill(ma);
-    for(int ord=0; ord!=4; ++ord) {
-      int nn = ord+1;
-      double dphi = a.Phi() - fQ[ord]->Psi2Pi();
-      double cos = TMath::Cos( nn*dphi );
-      hCos[ord][pb]->Fill(ma,cos);
-      if(nn==4) {
-	double dphi = a.Phi() - fQ[1]->Psi2Pi();
-	double cos = TMath::Cos( 4*dphi );
-	hCos[4][pb]->Fill(ma,cos);
-      }
-    }
+  for(int ord=0; ord!=4; ++ord) {
+    double a = (ord+1)*fQ[ord]->Psi2Pi();
+    fPsiC[ord] = TMath::Cos(a);
+    fPsiS[ord] = TMath::Sin(a);
   }
+  fPsiC[4] = TMath::Cos( 4*fQ[1]->Psi2Pi() );
+  fPsiS[4] = TMath::Sin( 4*fQ[1]->Psi2Pi() );
+  Fill( fCandidates, false ); // CANDIDATES 1
+  Fill( fCandidates2, true ); // CANDIDATES 2
+}
 
-  // CANDIDATES 2
-  npa = fCandidates2->size();
-  for(int i=0; i!=npa; ++i) {
-    TLorentzVector a = fCandidates2->at(i);
-    double ma = a.M();
-    double pt = a.Pt();
+void AT_EP::Fill(Candidates *cand, bool mixed) {
+  uint npa = cand->Size();
+  double cos[kNCos];
+  for(uint i=0; i!=npa; ++i) {
+    double ma = cand->Mass(i);
+    double pt = cand->Pt(i);
     int mb = BinMass( ma );
     int pb = BinPt( pt );
     if(mb<0||pb<0) continue;
+    double eta = cand->Eta(i);
+    double phi = cand->Phi(i);
+    // cos(n phi), sin(n phi) by complex powers of one cos/sin,
+    // then cos(n (phi-psi_n)) = cos(n phi)cos(n psi_n)+sin(n phi)sin(n psi_n)
+    double cn[kNCos], sn[kNCos];
+    cn[0] = TMath::Cos(phi);
+    sn[0] = TMath::Sin(phi);
+    for(int k=1; k!=4; ++k) {
+      cn[k] = cn[k-1]*cn[0] - sn[k-1]*sn[0];
+      sn[k] = sn[k-1]*cn[0] + cn[k-1]*sn[0];
+    }
+    cn[4] = cn[3];
+    sn[4] = sn[3];
+    for(int n=0; n!=kNCos; ++n)
+      cos[n] = cn[n]*fPsiC[n] + sn[n]*fPsiS[n];
+    int cell = pb*(kNProf+2) + CellMass(ma);
+    unsigned int pass = cand->Cuts(i); // untagged producers: nominal only
     /// recording
-    hEta2->Fill( a.Eta() );
-    hMass2[pb]->Fill(ma);
-    for(int ord=0; ord!=4; ++ord) {
-      int nn = ord+1;
-      double dphi = a.Phi() - fQ[ord]->Psi2Pi();
-      double cos = TMath::Cos( nn*dphi );
-      hCos2[ord][pb]->Fill(ma,cos);
-      if(nn==4) {
-	double dphi = a.Phi() - fQ[1]->Psi2Pi();
-	double cos = TMath::Cos( 4*dphi );
-	hCos2[4][pb]->Fill(ma,cos);
+    for(uint v=0; v!=fHistos.size(); ++v) {
+      if( !(pass&(1u<<v)) ) continue;
+      EPHISTOS &h = fHistos[v];
+      if(mixed) {
+	h.hEta2->Fill( eta );
+	h.hMass2[pb]->Fill(ma);
+      } else {
+	h.hEta->Fill( eta );
+	h.hMass[pb]->Fill(ma);
+      }
+      FLOWACC &acc = fAcc[v*2+(mixed?1:0)];
+      acc.n[cell] += 1;
+      double *sum = &acc.sum[cell*kNCos];
+      double *sum2 = &acc.sum2[cell*kNCos];
+      for(int n=0; n!=kNCos; ++n) {
+	sum[n] += cos[n];
+	sum2[n] += cos[n]*cos[n];
       }
     }
   }
 }
 
 int AT_EP::BinPt(float pt) {
-  int ret = -1;
-  if( pt<fPtBins[0] || pt>fPtBins[fNpt] ) return ret;
-  for(int p=0; p!=fNpt+1; ++p) 
-    if(pt>fPtBins[p]) ret = p;
-  return ret;
+  // bin p holds fPtBins[p] < pt <= fPtBins[p+1]
+  if( pt<=fPtBins[0] || pt>fPtBins[fNpt] ) return -1;
+  int p = fPtLUT[ int((pt-fPtBins[0])/fPtStep) ];
+  while( p+1<fNpt && pt>fPtBins[p+1] ) ++p;
+  while( p>0 && pt<=fPtBins[p] ) --p;
+  return p;
 }
 
 int AT_EP::BinMass(float ma) {
-  int ret = -1;
-  if( ma<fMassBins[0] || ma>fMassBins[fNma] ) return ret;
-  for(int m=0; m!=fNma+1; ++m) 
-    if(ma>fMassBins[m]) ret = m;
-  return ret;
+  // only tells whether the candidate is in the mass window
+  if( ma<=fMassBins[0] || ma>fMassBins[fNma] ) return -1;
+  return 0;
+}
+
+int AT_EP::CellMass(float ma) {
+  // profile bin, as TAxis::FindFixBin
+  double lo = fMassBins[0], hi = fMassBins[fNma];
+  if(ma<lo) return 0;
+  if(ma>=hi) return kNProf+1;
+  return 1 + int( kNProf*(ma-lo)/(hi-lo) );
 }
@@ -1,6 +1,7 @@
 #ifndef __AT_EP_HH__
 #define __AT_EP_HH__
 
+#include <vector>
 #include "AnalysisTask.h"
 
 class TH1F;
@@ -10,6 +11,7 @@ class AT_EP : public AnalysisTask {
  public:
   AT_EP();
   virtual ~AT_EP();
+  virtual AnalysisTask* CloneTask() const {return new AT_EP(*this);}
   virtual void Init();
   virtual void Exec();
   virtual void Finish();
@@ -17,17 +19,41 @@ class AT_EP : public AnalysisTask {
  private:
   int BinPt(float);
   int BinMass(float);
+  int CellMass(float);
 
   int fNpt;
   float fPtBins[100];
   int fNma;
   float fMassBins[100];
-  TH1F *hEta;
-  TH1F *hEta2;
-  TH1F *hMass[100];
-  TProfile *hCos[5][100];
-  TH1F *hMass2[100];
-  TProfile *hCos2[5][100];
+  std::vector<int> fPtLUT; // first pt bin of each fPtStep cell
+  float fPtStep;
+  void Fill(Candidates *cand, bool mixed);
+
+  // sums behind the hCos profiles of one cut set, same event or mixed:
+  // entries [pt][mass cell] and cos, cos^2 [pt][mass cell][n]; mass
+  // cells are the profile bins with under- and overflow. Finish turns
+  // them into the profiles, which hadd and the thread merge add up.
+  enum {kNCos=5, kNProf=120};
+  struct FLOWACC {
+    std::vector<double> n;
+    std::vector<double> sum;
+    std::vector<double> sum2;
+  };
+  std::vector<FLOWACC> fAcc; // [set*2+mixed]
+  double fPsiC[kNCos]; // cos and sin of n psi_n of the event,
+  double fPsiS[kNCos]; // [4] is 4 psi_2
+
+  struct EPHISTOS {
+    TH1F *hEta;
+    TH1F *hEta2;
+    TH1F *hMass[100];
+    TProfile *hCos[5][100];
+    TH1F *hMass2[100];
+    TProfile *hCos2[5][100];
+  };
+  // one set per candidate cut variation, [0] is the nominal set
+  std::vector<EPHISTOS> fHistos;
+  std::vector<TString> fCutNames;
 
 };
 
@@ -3,74 +3,57 @@
 #include <TTree.h>
 #include <TH1F.h>
 #include <TH2F.h>
+#include <TProfile.h>
 #include <TProfile2D.h>
 #include <TMath.h>
 
 #include "Analysis.h"
+#include "EPCorrection.h"
 #include "AT_MX_EPC.h"
 
 AT_MX_EPC::AT_MX_EPC() : AT_ReadTree() {
 }
 
 AT_MX_EPC::~AT_MX_EPC() {
-  //Should delete histograms, otherwise leak.
-  //But this is the end anyway, so it does not matter
+  //histograms belong to fHistos
 }
+void AT_MX_EPC::MyBranches(std::vector<TString> &brs) {
+  brs.push_back("Q1ex");
+  brs.push_back("Q2ex");
+  brs.push_back("Q3ex");
+  brs.push_back("Q4ex");
+  brs.push_back("Q6ex");
+  brs.push_back("Q8ex");
+}
+
 void AT_MX_EPC::MyInit() {
-  Analysis *ana = Analysis::Instance();
-  int run = ana->RunNumber();
-  for(int i=0; i!=fNBinsCen; ++i) { //centrality
-    for(int k=0; k!=6; ++k) { // order
-      for(int j=0; j!=8; ++j) { // subevent
-	hQxVtx[k][j][i] = new TH2F( Form("MXQ%dx_S%d_CB%02d",k+1,j,i), "MXQx;VtxBin",
-				    fNBinsVtx, -0.5, fNBinsVtx-0.5, 60, -50, +50 );
-	hQyVtx[k][j][i] = new TH2F( Form("MXQ%dy_S%d_CB%02d",k+1,j,i), "MXQy;VtxBin",
-				    fNBinsVtx, -0.5, fNBinsVtx-0.5, 60, -50, +50 );
-      }
-    }
-    for(int k=0; k!=4; ++k) { // order
-      hPsiC[k][i] = new TProfile2D( Form("MXPsiC_Ord%d_Cen%02d",k,i), "PsiC",
-				    fNBinsVtx, -0.5, fNBinsVtx-0.5, 32, 0.5, 32.5 );
-      hPsiS[k][i] = new TProfile2D( Form("MXPsiS_Ord%d_Cen%02d",k,i), "PsiS",
-				    fNBinsVtx, -0.5, fNBinsVtx-0.5, 32, 0.5, 32.5 );
-      hDeltaPsi[k][i] = new TH2F( Form("MXDeltaPsi_Ord%d_Cen%02d",k,i), "DeltaPsi",
-				  32, -0.5, 32-0.5, 100, -0.2, +0.2 );
-      hRes[k][i] = new TProfile( Form("MXRes_Ord%d_Cen%02d",k,i), "ResMX",
-				 fNBinsVtx, -0.5, fNBinsVtx-0.5, -1, +1 );
-      //fNBinsVtx, -0.5, fNBinsVtx-0.5, 100, -0.1, +0.1 );
-      for(int j=0; j!=8; ++j) { // subevent
-	for(int n=0; n!=3; ++n) { //step
-	  hQxC[n][k][j][i] = new TH1F( Form("MXQ%dxC_S%d_CB%02d_ST%d",k+1,j,i,n),
-				       "MXQx", 60, -30, +30 );
-	  hQyC[n][k][j][i] = new TH1F( Form("MXQ%dyC_S%d_CB%02d_ST%d",k+1,j,i,n),
-				       "MXQy", 60, -30, +30 );
-	}
-      }
-    }
-  }
+  // families are indexed in the order of the numbers in their names
+  fHistos.Add( new TH2F("MXQx","MXQx;VtxBin",fNBinsVtx,-0.5,fNBinsVtx-0.5,60,-50,+50),
+	       "MXQ%dx_S%d_CB%02d", 6,8,fNBinsCen,1, 1 );
+  fHistos.Add( new TH2F("MXQy","MXQy;VtxBin",fNBinsVtx,-0.5,fNBinsVtx-0.5,60,-50,+50),
+	       "MXQ%dy_S%d_CB%02d", 6,8,fNBinsCen,1, 1 );
+  fHistos.Add( new TH1F("MXQxC","MXQx",60,-30,+30),
+	       "MXQ%dxC_S%d_CB%02d_ST%d", 4,8,fNBinsCen,3, 1 );
+  fHistos.Add( new TH1F("MXQyC","MXQy",60,-30,+30),
+	       "MXQ%dyC_S%d_CB%02d_ST%d", 4,8,fNBinsCen,3, 1 );
+  fHistos.Add( new TProfile2D("MXPsiC","PsiC",fNBinsVtx,-0.5,fNBinsVtx-0.5,32,0.5,32.5),
+	       "MXPsiC_Ord%d_Cen%02d", 4,fNBinsCen );
+  fHistos.Add( new TProfile2D("MXPsiS","PsiS",fNBinsVtx,-0.5,fNBinsVtx-0.5,32,0.5,32.5),
+	       "MXPsiS_Ord%d_Cen%02d", 4,fNBinsCen );
+  fHistos.Add( new TH2F("MXDeltaPsi","DeltaPsi",32,-0.5,32-0.5,100,-0.2,+0.2),
+	       "MXDeltaPsi_Ord%d_Cen%02d", 4,fNBinsCen );
+  fHistos.Add( new TProfile("MXRes","ResMX",fNBinsVtx,-0.5,fNBinsVtx-0.5,-1,+1),
+	       "MXRes_Ord%d_Cen%02d", 4,fNBinsCen );
+  fFlat.Init( 4,fNBinsCen,fNBinsVtx );
 }
 
 void AT_MX_EPC::MyFinish() {
-  for(int i=0; i!=fNBinsCen; ++i) { // centrality
-    for(int k=0; k!=6; ++k) { // order
-      for(int j=0; j!=8; ++j) { // subevent
-	hQxVtx[k][j][i]->Write();
-	hQyVtx[k][j][i]->Write();
-      }
-    }
-    for(int k=0; k!=4; ++k) { // order
-      hPsiC[k][i]->Write();
-      hPsiS[k][i]->Write();
-      hDeltaPsi[k][i]->Write();
-      hRes[k][i]->Write();
-      for(int j=0; j!=8; ++j) { // subevent
-	for(int n=0; n!=3; ++n) { //step
-	  hQxC[n][k][j][i]->Write();
-	  hQyC[n][k][j][i]->Write();
-	}
-      }
-    }
-  }
+  std::cout << "AT_MX_EPC::MyFinish === " << fHistos.Booked() << " histograms booked" << std::endl;
+  for(int k=0; k!=4; ++k) // order
+    for(int i=0; i!=fNBinsCen; ++i) // centrality
+      if(fFlat.Filled(k,i))
+	fFlat.Export(k,i,(TProfile2D*) fHistos.Get(kPsiC,k,i),(TProfile2D*) fHistos.Get(kPsiS,k,i));
+  fHistos.Write();
 }
 
 void AT_MX_EPC::MyExec() {
@@ -79,7 +62,7 @@ void AT_MX_EPC::MyExec() {
   int bvtx = BinVertex( vtx );
   int bcen = BinCentrality( cen );
 
-  qcQ qvec[6][9];
+  qcQ qvec[6][8];
   for(int se=0; se!=8; ++se) {
     qvec[0][se] = pQ1ex->at(se);
     qvec[1][se] = pQ2ex->at(se);
@@ -94,111 +77,34 @@ void AT_MX_EPC::MyExec() {
   // ======= STAGE 1: Storing Raw Centroids =======
   for(int j=0; j!=8; ++j) { // subevent
     for(int k=0; k!=6; ++k) { //order
-      hQxVtx[k][j][bcen]->Fill( bvtx, qvec[k][j].X() );
-      hQyVtx[k][j][bcen]->Fill( bvtx, qvec[k][j].Y() );
-    }
-  }
-
-  // ======= STAGE 2: Recentering SubEvents (STEP1)  =======
-  for(int k=0; k!=6; ++k) { // order
-    for(int j=0; j!=8; ++j) { // subevent
-      double x = qvec[k][j].X();
-      double y = qvec[k][j].Y();
-      double cn = fMXm[j][k][0][bcen][bvtx];
-      double sn = fMXm[j][k][1][bcen][bvtx];
-      qvec[k][j].SetXY( x - cn, y - sn, qvec[k][j].NP(), qvec[k][j].M() );
-    }
-  }
-
-  // ======= STAGE 3: Storing Prime Centroids =======
-  for(int j=0; j!=8; ++j) { // subevent
-    for(int k=0; k!=4; ++k) { //order
-      hQxC[0][k][j][bcen]->Fill( qvec[k][j].X() );
-      hQyC[0][k][j][bcen]->Fill( qvec[k][j].Y() );
-    }
-  }
-
-  int twon[4] = {1,3,4,5}; // 1,2,3,4,6,8
-  // ======= STAGE 4: Twisting SubEvents (STEP2)  =======
-  for(int k=0; k!=4; ++k) { // order
-    for(int j=0; j!=8; ++j) { // subevent
-      double x = qvec[k][j].X();
-      double y = qvec[k][j].Y();
-      double c2n = bbcm[j][twon[k]][0][bcen][bvtx] / qvec[k][j].M();
-      double s2n = bbcm[j][twon[k]][1][bcen][bvtx] / qvec[k][j].M();
-      double ldaSm = s2n/(1.0+c2n);
-      double ldaSp = s2n/(1.0-c2n);
-      double den = 1.0 - ldaSm*ldaSp;
-      qvec[k][j].SetXY( (x-ldaSm*y) / den,
-			(y-ldaSp*x) / den,
-			qvec[k][j].NP(),
-			qvec[k][j].M() );
-      if( TMath::IsNaN( qvec[k][j].X() ) || TMath::IsNaN( qvec[k][j].Y() ) ) {
-	std::cout << "Error building coefficient ";
-	std::cout << " | qvec.M: " << qvec[k][j].M();
-	std::cout << " | c2n: " << c2n;
-	std::cout << " | s2n: " << s2n;
-	std::cout << " | ldaSm: " << ldaSm;
-	std::cout << " | ldaSp: " << ldaSp;
-	std::cout << " | den: " << den << std::endl;
-      }
-    }
-  }
-
-  // ======= STAGE 5: Storing Double-Prime Centroids =======
-  for(int j=0; j!=8; ++j) { // subevent
-    for(int k=0; k!=4; ++k) { //order
-      hQxC[1][k][j][bcen]->Fill( qvec[k][j].X() );
-      hQyC[1][k][j][bcen]->Fill( qvec[k][j].Y() );
-    }
-  }
-
-  // ======= STAGE 6: Rescaling SubEvents (STEP3)  =======
-  for(int k=0; k!=4; ++k) { // order
-    for(int j=0; j!=8; ++j) { // subevent
-      double x = qvec[k][j].X();
-      double y = qvec[k][j].Y();
-      double c2n = bbcm[j][twon[k]][0][bcen][bvtx] / qvec[k][j].M();
-      double a2np = 1.0+c2n;
-      double a2nm = 1.0-c2n;
-      qvec[k][j].SetXY( x / a2np,
-			y / a2nm,
-			qvec[k][j].NP(),
-			qvec[k][j].M() );
-      if( TMath::IsNaN( qvec[k][j].X() ) || TMath::IsNaN( qvec[k][j].Y() ) ) {
-	std::cout << "Error building coefficient [2] ";
-	std::cout << " | a2np: " << a2np;
-	std::cout << " | a2nm: " << a2nm << std::endl;
-      }
-    }
-  }
-
-  // ======= STAGE 7: Storing Triple-Prime Centroids =======
-  for(int j=0; j!=8; ++j) { // subevent
-    for(int k=0; k!=4; ++k) { //order
-      hQxC[2][k][j][bcen]->Fill( qvec[k][j].X() );
-      hQyC[2][k][j][bcen]->Fill( qvec[k][j].Y() );
+      fHistos.Get(kQxVtx,k,j,bcen)->Fill( bvtx, qvec[k][j].X() );
+      fHistos.Get(kQyVtx,k,j,bcen)->Fill( bvtx, qvec[k][j].Y() );
     }
   }
 
+  // ======= STAGES 2-7: Recentering, Twisting and Rescaling SubEvents,
+  // storing Prime, Double-Prime and Triple-Prime Centroids =======
+  const MXCell &cell = fCalib->MX(bcen,bvtx);
+  EPCorrection<MXCell,8> epc;
+  for(int k=0; k!=4; ++k) // order
+    for(int j=0; j!=8; ++j) // subevent
+      epc.Load(k,j,qvec[k][j]);
+  EPCorrection<MXCell,8>::CentroidHook hook = {&fHistos,kQxC,kQyC,bcen};
+  epc.Correct(cell,hook);
 
   // ======= STAGE 8: Bulding Full Q and Storing Flattening Coeficients  =======
+  double cosn[Harmonics::kN], sinn[Harmonics::kN];
   for(int k=0; k!=4; ++k) { // order
-    hRes[k][bcen]->Fill(bvtx, TMath::Cos( (k+1)*(qvec[k][0].Psi2Pi()-qvec[k][1].Psi2Pi()) ) );
-    qvec[k][8] = qvec[k][0] + qvec[k][1] + qvec[k][2] + qvec[k][3]
-      + qvec[k][4] + qvec[k][5] + qvec[k][6] + qvec[k][7];
-    for(int ik=0; ik!=32; ++ik) { // correction order
-      int nn = 1+ik;
-      hPsiC[k][bcen]->Fill(bvtx, nn, TMath::Cos(nn*qvec[k][8].Psi2Pi()) );
-      hPsiS[k][bcen]->Fill(bvtx, nn, TMath::Sin(nn*qvec[k][8].Psi2Pi()) );
-    }
-    double psi = qvec[k][8].Psi2Pi();
+    fHistos.Get(kRes,k,bcen)->Fill(bvtx, TMath::Cos( (k+1)*(epc.Sub(k,0).Psi2Pi()-epc.Sub(k,1).Psi2Pi()) ) );
+    double psi = epc.Full(k).Psi2Pi();
+    Harmonics::CosSin(psi,cosn,sinn);
+    fFlat.Fill(k,bcen,bvtx,cosn,sinn);
     for(int ik=0; ik!=32; ++ik) { // correction order
       int nn = ik+1;
       double prime = 0.0;
-      prime += TMath::Cos(nn*psi)*fMXc[ik][k][bcen][bvtx]*2.0/nn;
-      prime += TMath::Sin(nn*psi)*fMXs[ik][k][bcen][bvtx]*2.0/nn;
-      hDeltaPsi[k][bcen]->Fill(ik, prime);
+      prime += cosn[ik]*cell.c[k][ik]*2.0/nn;
+      prime += sinn[ik]*cell.s[k][ik]*2.0/nn;
+      fHistos.Get(kDeltaPsi,k,bcen)->Fill(ik, prime);
     }
   }
 }
@@ -3,10 +3,24 @@
 #include <TMath.h>
 #include <TH1F.h>
 #include <TH2F.h>
+#include <TDirectory.h>
 #include "Analysis.h"
 #include "AT_PIDFlow.h"
 
 AT_PIDFlow::AT_PIDFlow() : AT_ReadTree() {
+  hPt = NULL;
+  hNTrk = NULL;
+  for(int i=0; i!=4; ++i) {
+    hPtDPhi[i] = NULL;
+    hPtDPhiME[i] = NULL;
+    hEP_BBC[i] = NULL;
+  }
+  // no previous event yet: nothing to mix with
+  fHavePE = false;
+  fPsi1_BBC_PE = 0;
+  fPsi2_BBC_PE = 0;
+  fPsi3_BBC_PE = 0;
+  fPsi4_BBC_PE = 0;
 }
 
 AT_PIDFlow::~AT_PIDFlow() {
@@ -19,6 +33,15 @@ AT_PIDFlow::~AT_PIDFlow() {
   }
 }
 
+void AT_PIDFlow::MyBranches(std::vector<TString> &brs) {
+  brs.push_back("TRKqua");
+  brs.push_back("TRKpt");
+  brs.push_back("TRKphi");
+  brs.push_back("TRKzed");
+  brs.push_back("TRKpc3sdphi");
+  brs.push_back("TRKpc3sdz");
+}
+
 void AT_PIDFlow::MyInit() {
   hPt =   new TH1F("hPt",  "hPt", 100,0.0,5.0);
   hNTrk = new TH1F("hNTrk","hNTrk",100,-0.5,99.5);
@@ -42,34 +65,68 @@ void AT_PIDFlow::MyFinish() {
   }
 }
 
-void AT_PIDFlow::MyExec() {
+bool AT_PIDFlow::Accept() {
   float vtxz = fGLB.vtxZ;
   float cent = fGLB.cent;
-  if(TMath::Abs(vtxz)>20) return;
-  if(cent<0||cent>5) return;
-  if(ReferenceTracks()<2) return;
-  if(!Psi_BBC) return;
+  if(TMath::Abs(vtxz)>20) return false;
+  if(cent<0||cent>5) return false;
+  if(ReferenceTracks()<2) return false;
+  if(!Psi_BBC) return false;
+  return true;
+}
+
+bool AT_PIDFlow::MyHistory(bool selected) {
+  // the planes of the last event accepted before the range
+  if(!selected || !Accept()) return true;
+  fHavePE = true;
+  fPsi1_BBC_PE = Psi1_BBC;
+  fPsi2_BBC_PE = Psi2_BBC;
+  fPsi3_BBC_PE = Psi3_BBC;
+  fPsi4_BBC_PE = Psi4_BBC;
+  return false;
+}
+
+void AT_PIDFlow::SaveState(TDirectory *dir) {
+  // planes of the previous event, so that a resumed job mixes with them
+  dir->cd();
+  TTree *pe = new TTree("PreviousEvent","AT_PIDFlow previous event");
+  int have = fHavePE;
+  pe->Branch("have",&have,"have/I");
+  pe->Branch("psi1",&fPsi1_BBC_PE,"psi1/F");
+  pe->Branch("psi2",&fPsi2_BBC_PE,"psi2/F");
+  pe->Branch("psi3",&fPsi3_BBC_PE,"psi3/F");
+  pe->Branch("psi4",&fPsi4_BBC_PE,"psi4/F");
+  pe->Fill();
+  pe->Write();
+  delete pe;
+}
+
+void AT_PIDFlow::LoadState(TDirectory *dir) {
+  TTree *pe = (TTree*) dir->Get("PreviousEvent");
+  if(!pe) return;
+  int have = 0;
+  pe->SetBranchAddress("have",&have);
+  pe->SetBranchAddress("psi1",&fPsi1_BBC_PE);
+  pe->SetBranchAddress("psi2",&fPsi2_BBC_PE);
+  pe->SetBranchAddress("psi3",&fPsi3_BBC_PE);
+  pe->SetBranchAddress("psi4",&fPsi4_BBC_PE);
+  if(pe->GetEntries()>0) pe->GetEntry(0);
+  fHavePE = have!=0;
+  delete pe;
+}
+
+void AT_PIDFlow::MyExec() {
+  if(!Accept()) return;
   hEP_BBC[0]->Fill(Psi1_BBC);
   hEP_BBC[1]->Fill(Psi2_BBC);
   hEP_BBC[2]->Fill(Psi3_BBC);
   hEP_BBC[3]->Fill(Psi4_BBC);
   int ntrk=0;
-  uint ntrks = pTRKpt->size();
-  for(uint itrk=0; itrk!=ntrks; ++itrk) {
-    float pt   = TMath::Abs( pTRKpt->at(itrk) );
-    float pz   = pTRKpz->at(itrk);
-    float phi  = pTRKphi->at(itrk);
-    float ep   = pTRKecore->at(itrk) / TMath::Sqrt(pt*pt+pz*pz);
-    float tof  = pTRKetof->at(itrk);
-    float chi2 = pTRKchisq->at(itrk);
-    float dphi = pTRKpc3sdphi->at(itrk);
-    float dz   = pTRKpc3sdz->at(itrk);
-    float zed  = pTRKzed->at(itrk);
-    int qua = pTRKqua->at(itrk);
-    if(qua!=63) continue;
-    if(TMath::Abs(zed)<3||TMath::Abs(zed)>70) continue;
-    if(TMath::Abs(dphi)>3) continue;
-    if(TMath::Abs(dz)>3) continue;
+  const std::vector<unsigned int> &sel = fTracks->Selected();
+  for(uint i=0; i!=sel.size(); ++i) {
+    uint itrk = sel[i];
+    float pt   = TMath::Abs( (*pTRKpt)[itrk] );
+    float phi  = (*pTRKphi)[itrk];
     ntrk++;
     hPt->Fill(pt);
     float dphi1 = phi - Psi1_BBC;
@@ -80,6 +137,7 @@ void AT_PIDFlow::MyExec() {
     hPtDPhi[1]->Fill(pt,dphi2);
     hPtDPhi[2]->Fill(pt,dphi3);
     hPtDPhi[3]->Fill(pt,dphi4);
+    if(!fHavePE) continue;
     float dphi1me = phi - fPsi1_BBC_PE;
     float dphi2me = phi - fPsi2_BBC_PE;
     float dphi3me = phi - fPsi3_BBC_PE;
@@ -90,6 +148,7 @@ void AT_PIDFlow::MyExec() {
     hPtDPhiME[3]->Fill(pt,dphi4me);
   }
   hNTrk->Fill(ntrk);
+  fHavePE = true;
   fPsi1_BBC_PE = Psi1_BBC;
   fPsi2_BBC_PE = Psi2_BBC;
   fPsi3_BBC_PE = Psi3_BBC;
@@ -10,16 +10,23 @@ class AT_PIDFlow : public AT_ReadTree {
  public:
   AT_PIDFlow();
   virtual ~AT_PIDFlow();
+  virtual AnalysisTask* CloneTask() const {return new AT_PIDFlow(*this);}
+  virtual void MyBranches(std::vector<TString> &brs);
   virtual void MyInit();
   virtual void MyExec();
+  virtual bool MyHistory(bool selected);
   virtual void MyFinish();
+  virtual void SaveState(TDirectory *dir);
+  virtual void LoadState(TDirectory *dir);
 
  private:
+  bool Accept();
   TH1F *hPt;
   TH1F *hNTrk;
   TH2F *hPtDPhi[4];
   TH2F *hPtDPhiME[4];
   TH1F *hEP_BBC[4];
+  bool fHavePE; // planes of the previous accepted event
   float fPsi1_BBC_PE;
   float fPsi2_BBC_PE;
   float fPsi3_BBC_PE;
@@ -1,11 +1,14 @@
 #include <iostream>
 #include <fstream>
 #include <vector>
+#include <cmath>
 #include <TString.h>
 #include <TTree.h>
 #include <TH1F.h>
 #include <TH2F.h>
 #include <TProfile.h>
+#include <TDirectory.h>
+#include "Analysis.h"
 #include "AT_PiZero.h"
 #include "EmcIndexer.h"
 #include "EmcIndexer.C"
@@ -13,23 +16,31 @@
 #include "PbScIndexer.C"
 
 AT_PiZero::AT_PiZero() : AT_ReadTree() {
-  for (int i = 0; i < 8; ++i){
-    for (int j = 0; j < 48; ++j){
-      for (int k = 0; k < 96; ++k){
-	EMCMAP[i][j][k] = 0;
-      }
-    }
-  }
+  std::vector<int> emcmap(8*48*96,0); // [sector][y][z]
   TString fname = "Run16dAu200WarnMap.list";
   std::cout << "AT_PiZero::Ctor === is reading EMCal dead map: ";
   std::cout << fname.Data() << std::endl;
   int armsect = 0, ypos = 0, zpos = 0, status = 0;
   ifstream readmap( fname.Data() );
   while(readmap >> armsect >> ypos >> zpos >> status) {
-    EMCMAP[armsect][ypos][zpos] = status;
+    emcmap[(armsect*48+ypos)*96+zpos] = status;
     //if(status==-1)EMCMAP[armsect][ypos][zpos] = 0; // this is for ERT trigger
   }
   readmap.close();
+  // the map is in veronica's sector convention (4<->5, 6<->7)
+  int vsc[8] = {0,1,2,3,5,4,7,6};
+  for(int i=0; i!=kNTowers/32; ++i) fBadTower[i] = 0;
+  for(int twr=0; twr!=kNTowers; ++twr) {
+    const EmcTowerInfo &tw = EmcIndexer::Tower(twr);
+    int sc = vsc[tw.iS], y = tw.y, z = tw.x;
+    bool bad = y==0 || z==0;
+    if( sc < 6 && ( y == 35 || z == 71) ) bad = true;
+    if( sc > 5 && ( y == 47 || z == 95) ) bad = true;
+    for(int dy=-1; dy!=2 && !bad; ++dy)
+      for(int dz=-1; dz!=2 && !bad; ++dz)
+	if( emcmap[(sc*48+y+dy)*96+z+dz] ) bad = true;
+    if(bad) fBadTower[twr>>5] |= 1u<<(twr&31);
+  }
   fQA = false;
   hVertex = NULL;
   hCentrality = NULL;
@@ -46,10 +57,37 @@ AT_PiZero::AT_PiZero() : AT_ReadTree() {
   fCuts.dist = 8; // cm
   fCuts.alpha = 0.8;
   fCuts.time = 5; //ns
+  fMixDepth = 1;
+  fMixCen = 1;
+  fMixPsi = 1;
+  fHistoryOpen = 0;
+  fHistoryRead = 0;
 }
 AT_PiZero::~AT_PiZero() {
 }
 
+void AT_PiZero::AddVariation(TString name, float dist, float alpha, float time) {
+  if(fVariations.size()==31) {
+    std::cout << "AT_PiZero::AddVariation === too many variations, ignoring " << name.Data() << std::endl;
+    return;
+  }
+  PI0CUTS cuts = fCuts;
+  cuts.dist = dist;
+  cuts.alpha = alpha;
+  cuts.time = time;
+  fVariations.push_back( cuts );
+  fVariationNames.push_back( name );
+}
+
+void AT_PiZero::MyBranches(std::vector<TString> &brs) {
+  brs.push_back("EMCtwrid");
+  brs.push_back("EMCtimef");
+  brs.push_back("EMCecore");
+  brs.push_back("EMCx");
+  brs.push_back("EMCy");
+  brs.push_back("EMCz");
+}
+
 void AT_PiZero::MyInit() {
   if(fQA) {
     hVertex = new TH1F("Vertex","",100,-30,+30);
@@ -70,6 +108,33 @@ void AT_PiZero::MyInit() {
   std::cout << "DIST " << fCuts.dist << std::endl;
   std::cout << "ALPHA " << fCuts.alpha << std::endl;
   std::cout << "TIME " << fCuts.time << std::endl;
+  // bit 0 is the nominal set, bit i+1 the i-th variation
+  fAllCuts.clear();
+  fAllCuts.push_back( fCuts );
+  std::vector<TString> *names = Analysis::Instance()->GetCandidateCutNames();
+  names->clear();
+  names->push_back( "" );
+  for(uint i=0; i!=fVariations.size(); ++i) {
+    fVariations[i].minPt = fCuts.minPt;
+    fVariations[i].maxPt = fCuts.maxPt;
+    fAllCuts.push_back( fVariations[i] );
+    names->push_back( fVariationNames[i] );
+    std::cout << "VARIATION " << fVariationNames[i].Data() << " DIST " << fVariations[i].dist;
+    std::cout << " ALPHA " << fVariations[i].alpha << " TIME " << fVariations[i].time << std::endl;
+  }
+  if(fMixDepth<1) fMixDepth = 1;
+  if(fMixCen<1) fMixCen = 1;
+  if(fMixPsi<1) fMixPsi = 1;
+  int nbins = 20*fMixCen*fMixPsi;
+  fPool.assign(nbins*fMixDepth,MIXEVENT());
+  fPoolFill.assign(nbins,0);
+  fPoolNext.assign(nbins,0);
+  std::cout << "MIXING " << fMixDepth << " events x 20 vtx x " << fMixCen << " cen x " << fMixPsi << " psi2" << std::endl;
+  fLoose = fCuts;
+  for(uint i=0; i!=fVariations.size(); ++i) {
+    fLoose.dist = TMath::Min( fLoose.dist, fVariations[i].dist );
+    fLoose.alpha = TMath::Max( fLoose.alpha, fVariations[i].alpha );
+  }
 }
 
 void AT_PiZero::MyFinish() {
@@ -87,21 +152,166 @@ void AT_PiZero::MyFinish() {
   }
 }
 
+void AT_PiZero::SaveState(TDirectory *dir) {
+  // mixing pools, so that a resumed job mixes with the same events
+  dir->cd();
+  TTree *pool = new TTree("MixingPool","AT_PiZero mixing pool");
+  int bin, evt;
+  FASTCLU clu;
+  pool->Branch("bin",&bin,"bin/I");
+  pool->Branch("evt",&evt,"evt/I"); // oldest first
+  pool->Branch("clu",&clu,"ecore/F:idx/I:x/F:y/F:z/F:t/F");
+  for(bin=0; bin!=(int)fPoolFill.size(); ++bin) {
+    for(evt=0; evt!=fPoolFill[bin]; ++evt) {
+      int slot = (fPoolNext[bin]-fPoolFill[bin]+evt+fMixDepth)%fMixDepth;
+      const MIXEVENT &ev = fPool[bin*fMixDepth+slot];
+      for(uint i=0; i!=ev.clu.size(); ++i) {
+	clu = ev.clu[i];
+	pool->Fill();
+      }
+    }
+  }
+  pool->Write();
+  delete pool;
+}
+
+void AT_PiZero::LoadState(TDirectory *dir) {
+  TTree *pool = (TTree*) dir->Get("MixingPool");
+  if(!pool) return;
+  int bin, evt=0;
+  FASTCLU clu;
+  for(uint i=0; i!=fPool.size(); ++i) fPool[i].clear();
+  for(uint i=0; i!=fPoolFill.size(); ++i) fPoolFill[i] = fPoolNext[i] = 0;
+  // states without "evt" hold one event per vertex bin; with a single
+  // centrality and psi class that bin is still the pool of the vertex
+  bool old = !pool->GetBranch("evt");
+  if(old && (fMixCen>1 || fMixPsi>1)) {
+    std::cout << "AT_PiZero::LoadState === mixing state has no centrality/psi bins, pools start empty" << std::endl;
+    delete pool;
+    return;
+  }
+  pool->SetBranchAddress("bin",&bin);
+  if(!old) pool->SetBranchAddress("evt",&evt);
+  pool->SetBranchAddress("clu",&clu);
+  int lastbin=-1, lastevt=-1;
+  MIXEVENT *ev = NULL;
+  for(Long64_t i=0; i!=pool->GetEntries(); ++i) {
+    pool->GetEntry(i);
+    if(bin<0 || bin>=(int)fPoolFill.size()) continue; // other binning
+    if(bin!=lastbin || evt!=lastevt) {
+      ev = &PoolStore(bin);
+      ev->clear();
+      lastbin = bin;
+      lastevt = evt;
+    }
+    int sc = EmcIndexer::TowerSector(clu.idx);
+    ev->clu.push_back( clu );
+    ev->sector[sc].push( clu );
+  }
+  delete pool;
+}
+
+int AT_PiZero::MixingBin(int bvtx, float cent) {
+  int bcen = 0;
+  if(fMixCen>1 && fCentralityMax>fCentralityMin)
+    bcen = TMath::Min( int(fMixCen*(cent-fCentralityMin)/(fCentralityMax-fCentralityMin)), fMixCen-1 );
+  int bpsi = 0;
+  if(fMixPsi>1) {
+    if(!Psi_BBC) return -1; // no event plane, no psi class
+    // 2 psi2 folded into [0,2pi), whatever range psi2 comes in
+    double phase = TMath::ATan2( TMath::Sin(2*Psi2_BBC), TMath::Cos(2*Psi2_BBC) );
+    if(phase<0) phase += TMath::TwoPi();
+    bpsi = TMath::Min( int(fMixPsi*phase/TMath::TwoPi()), fMixPsi-1 );
+  }
+  return (bvtx*fMixCen + bcen)*fMixPsi + bpsi;
+}
+
+AT_PiZero::MIXEVENT& AT_PiZero::PoolStore(int bin) {
+  // oldest event of the ring, which becomes the newest
+  int slot = fPoolNext[bin];
+  fPoolNext[bin] = (slot+1)%fMixDepth;
+  if(fPoolFill[bin]<fMixDepth) fPoolFill[bin]++;
+  return fPool[bin*fMixDepth+slot];
+}
+
+bool AT_PiZero::PassEvent() {
+  unsigned int trigger = fGLB.trig;
+  bool trig = false;
+  if(trigger & fMask) trig = true;
+  if(fGLB.cent<fCentralityMin||fGLB.cent>fCentralityMax) return false;
+  if(fGLB.frac<0.95) return false;
+  if(!trig) return false;
+  if(fabs(fGLB.vtxZ)>20) return false;
+  return true;
+}
+
+void AT_PiZero::CurrentClusters(float vtxZ, int *nclu0, int *nclu1) {
+  fCurrent.clear();
+  GoodClusters(*pEMCtwrid,fGood);
+  for(uint ig=0; ig!=fGood.size(); ++ig) {
+    uint icl = fGood[ig];
+    int idx = pEMCtwrid->at(icl);
+    float it = pEMCtimef->at(icl);
+    int isc = EmcIndexer::TowerSector(idx); // good towers are valid ids
+    nclu0[isc]++;
+    if( fabs(it)<fCuts.time ) nclu1[isc]++;
+    FASTCLU clu;
+    clu.ecore = pEMCecore->at(icl);
+    clu.idx = idx;
+    clu.x = pEMCx->at(icl);
+    clu.y = pEMCy->at(icl);
+    clu.z = pEMCz->at(icl) - vtxZ;
+    clu.t = it;
+    fCurrent.clu.push_back( clu );
+    fCurrent.sector[isc].push( clu );
+  }
+}
+
+bool AT_PiZero::MyHistory(bool selected) {
+  // what a serial run would pool up to here: the newest <depth> pooled
+  // events of every bin, collected newest first
+  if(fHistory.size()!=fPoolFill.size()) {
+    fHistory.assign(fPoolFill.size(),std::vector<MIXEVENT>());
+    fHistoryOpen = fPoolFill.size();
+    fHistoryRead = 0;
+  }
+  // bins that never fill (centralities the event selection drops, sparse
+  // psi bins) would otherwise send us back to the first entry
+  if(++fHistoryRead > (Long64_t)kHistoryFactor*fMixDepth*fPoolFill.size()) {
+    std::cout << "AT_PiZero::MyHistory === gave up after " << fHistoryRead-1
+	      << " entries with " << fHistoryOpen << " bins not full" << std::endl;
+    return false;
+  }
+  if(!selected || !PassEvent()) return fHistoryOpen>0;
+  int binvertex = P0_VertexBin(fGLB.vtxZ);
+  if(binvertex<0) return fHistoryOpen>0;
+  int binmix = MixingBin(binvertex,fGLB.cent);
+  if(binmix<0 || (int)fHistory[binmix].size()==fMixDepth) return fHistoryOpen>0;
+  int nclu0[8] = {0,0,0,0,0,0,0,0};
+  int nclu1[8] = {0,0,0,0,0,0,0,0};
+  CurrentClusters(fGLB.vtxZ,nclu0,nclu1);
+  if(fCurrent.clu.size()==0) return fHistoryOpen>0;
+  fHistory[binmix].push_back( MIXEVENT() );
+  fHistory[binmix].back().swap( fCurrent );
+  if((int)fHistory[binmix].size()==fMixDepth) --fHistoryOpen;
+  return fHistoryOpen>0;
+}
+
+void AT_PiZero::EndHistory() {
+  for(uint bin=0; bin!=fHistory.size(); ++bin)
+    for(int i=fHistory[bin].size()-1; i>=0; --i)
+      PoolStore(bin).swap( fHistory[bin][i] );
+  fHistory.clear();
+}
+
 void AT_PiZero::MyExec() {
-  fCandidates->clear();
-  fCandidates2->clear();
+  fCandidates->Clear();
+  fCandidates2->Clear();
   
   //====== EVENT SELECTION ======
   float cent = fGLB.cent;
-  float frac = fGLB.frac;
   float vtxZ = fGLB.vtxZ;
-  unsigned int trigger = fGLB.trig;
-  bool trig = false;
-  if(trigger & fMask) trig = true;
-  if(cent<fCentralityMin||cent>fCentralityMax) return;
-  if(frac<0.95) return;
-  if(!trig) return;
-  if(fabs(vtxZ)>20) return;
+  if(!PassEvent()) return;
   
   if(fQA) hCentrality->Fill(cent);
   if(fQA) hVertex->Fill(vtxZ);
@@ -110,123 +320,65 @@ void AT_PiZero::MyExec() {
   if(binvertex<0) return;
   hEvents->Fill(2);
   
-  //====== MAIN LOOP ON CLUSTERS ======
-  fBuffer.clear();
+  //====== CLUSTERS: decoded and checked once, bucketed by sector ======
   int nclu0[8] = {0,0,0,0,0,0,0,0};
   int nclu1[8] = {0,0,0,0,0,0,0,0};
-  int isc, jsc;
-  int y, z;
-  uint nclu = pEMCecore->size();
-  for(uint icl=0; icl!=nclu; ++icl) {
-    int idx = pEMCtwrid->at(icl);
-    float it = pEMCtimef->at(icl);
-    EmcIndexer::decodeTowerId(idx,isc,z,y);
-    if( IsBad(isc,y,z) ) continue;
-    nclu0[isc]++;
-    if( fabs(it)<fCuts.time ) nclu1[isc]++;
-    //=== loading cluster i
-    float iecore = pEMCecore->at(icl);
-    float ix = pEMCx->at(icl);
-    float iy = pEMCy->at(icl);
-    float iz = pEMCz->at(icl) - vtxZ;
-    double idl = TMath::Sqrt(ix*ix + iy*iy + iz*iz);
-    //=== buffering
-    FASTCLU clu;
-    clu.ecore = iecore;
-    clu.idx = idx;
-    clu.x = ix;
-    clu.y = iy;
-    clu.z = iz;
-    clu.t = it;
-    fBuffer.push_back( clu );
-    //=== continue
-    TLorentzVector ii;
-    ii.SetPx(iecore*ix/idl);
-    ii.SetPy(iecore*iy/idl);
-    ii.SetPz(iecore*iz/idl);
-    ii.SetE(iecore);
-    // building foreground
-    for(uint jcl=icl+1; jcl<nclu; ++jcl) {
-      int jdx = pEMCtwrid->at(jcl);
-      float jt = pEMCtimef->at(jcl);
-      EmcIndexer::decodeTowerId(jdx,jsc,z,y);
-      if(isc!=jsc) continue;
-      if( IsBad(jsc,y,z) ) continue;
-      //=== loading cluster j
-      float jecore = pEMCecore->at(jcl);
-      float jidx = pEMCtwrid->at(jcl);
-      float jx = pEMCx->at(jcl);
-      float jy = pEMCy->at(jcl);
-      float jz = pEMCz->at(jcl) - vtxZ;
-      double jdl = TMath::Sqrt(jx*jx + jy*jy + jz*jz);
-      TLorentzVector jj;
-      jj.SetPx(jecore*jx/jdl);
-      jj.SetPy(jecore*jy/jdl);
-      jj.SetPz(jecore*jz/jdl);
-      jj.SetE(jecore);
-      
-      //=== building pair
-      TLorentzVector pp = ii + jj;
-      double dist = TMath::Sqrt( +(ix-jx)*(ix-jx)
-				 +(iy-jy)*(iy-jy)
-				 +(iz-jz)*(iz-jz) );
-      float alpha = TMath::Abs(iecore-jecore)/(iecore+jecore);
-      if(pp.Pt()<fCuts.minPt) continue;
-      if(pp.Pt()>fCuts.maxPt) continue;
-      if(fQA) hPizeroMass[0][isc]->Fill( pp.M(),pp.Pt()); // step0
-      if(dist<fCuts.dist) continue;
-      if(fQA) hPizeroMass[1][isc]->Fill( pp.M(),pp.Pt()); // step1
-      if(alpha>fCuts.alpha) continue;
-      if(fQA) hPizeroMass[2][isc]->Fill( pp.M(),pp.Pt()); // step2
-      if( fabs(it)>fCuts.time )continue;
-      if( fabs(jt)>fCuts.time )continue;
-      if(fQA) hPizeroMass[3][isc]->Fill( pp.M(),pp.Pt()); // step3
-      fCandidates->push_back( pp );
-    }
-    // building background
-    for(uint jcl=0; jcl!=fPrevious[binvertex].size(); ++jcl) {
-      float jecore = (fPrevious[binvertex].at(jcl)).ecore;
-      float jdx = (fPrevious[binvertex].at(jcl)).idx;
-      float jx = (fPrevious[binvertex].at(jcl)).x;
-      float jy = (fPrevious[binvertex].at(jcl)).y;
-      float jz = (fPrevious[binvertex].at(jcl)).z;
-      float jt = (fPrevious[binvertex].at(jcl)).t;
-      EmcIndexer::decodeTowerId(jdx,jsc,z,y);
-      //std::cout << "GOOD! " << isc << " " << jsc << std::endl;
-      if(isc!=jsc) continue;
-      if( IsBad(jsc,y,z) ) continue;
-      //std::cout << "VGOOD! " << ix << std::endl;
-      double jdl = TMath::Sqrt(jx*jx + jy*jy + jz*jz);
-      TLorentzVector jj;
-      jj.SetPx(jecore*jx/jdl);
-      jj.SetPy(jecore*jy/jdl);
-      jj.SetPz(jecore*jz/jdl);
-      jj.SetE(jecore);
-      TLorentzVector pp = ii + jj;
-      double dist = TMath::Sqrt( +(ix-jx)*(ix-jx)
-                                 +(iy-jy)*(iy-jy)
-                                 +(iz-jz)*(iz-jz) );
-      float alpha = TMath::Abs(iecore-jecore)/(iecore+jecore);
-      if(pp.Pt()<fCuts.minPt) continue;
-      if(pp.Pt()>fCuts.maxPt) continue;
-      if(dist<fCuts.dist) continue;
-      if(alpha>fCuts.alpha) continue;
-      if( fabs(it)>fCuts.time )continue;
-      if( fabs(jt)>fCuts.time )continue;
-      //std::cout << "VVGOOD! " << ix << std::endl;
-      if(fQA) hPizeroMixMass[isc]->Fill( pp.M(),pp.Pt());
-      fCandidates2->push_back( pp );
-    }
-  }
+  CurrentClusters(vtxZ,nclu0,nclu1);
 
-  if(fBuffer.size()>0) {
-    //d::cout << "Filling vertex " << binvertex << std::endl;
-    fPrevious[binvertex].clear();
-    for(uint i=0; i!=fBuffer.size(); ++i) {
-      fPrevious[binvertex].push_back( fBuffer[i] );
+  //====== PAIRS: only within a sector ======
+  int binmix = MixingBin(binvertex,cent);
+  for(int sc=0; sc!=8; ++sc) {
+    const SECTORCLU &cur = fCurrent.sector[sc];
+    for(int i=0; i<cur.size(); ++i) {
+      // building foreground
+      int np = cur.size()-i-1;
+      Pairs(cur,i,cur,i+1);
+      for(int k=0; k!=np; ++k) {
+	int j = i+1+k;
+	double ppt = fPairs.pt[k];
+	double dist = fPairs.dist[k];
+	float alpha = fPairs.alpha[k];
+	if(fQA && ppt>=fCuts.minPt && ppt<=fCuts.maxPt) { // nominal steps
+	  double mass = fPairs.m[k];
+	  hPizeroMass[0][sc]->Fill( mass,ppt); // step0
+	  if(dist>=fCuts.dist) {
+	    hPizeroMass[1][sc]->Fill( mass,ppt); // step1
+	    if(alpha<=fCuts.alpha) {
+	      hPizeroMass[2][sc]->Fill( mass,ppt); // step2
+	      if( fabs(cur.t[i])<=fCuts.time && fabs(cur.t[j])<=fCuts.time )
+		hPizeroMass[3][sc]->Fill( mass,ppt); // step3
+	    }
+	  }
+	}
+	if(ppt<fLoose.minPt || ppt>fLoose.maxPt || dist<fLoose.dist || alpha>fLoose.alpha) continue;
+	unsigned int cuts = PairCuts(ppt,dist,alpha,cur.t[i],cur.t[j]);
+	if(!cuts) continue;
+	fCandidates->AddPxPyPzM( fPairs.px[k],fPairs.py[k],fPairs.pz[k],fPairs.m[k],sc,cuts );
+      }
+      // building background, oldest event of the pool first
+      int nmix = binmix<0 ? 0 : fPoolFill[binmix];
+      for(int ie=0; ie!=nmix; ++ie) {
+	int slot = (fPoolNext[binmix]-nmix+ie+fMixDepth)%fMixDepth;
+	const SECTORCLU &mix = fPool[binmix*fMixDepth+slot].sector[sc];
+	Pairs(cur,i,mix,0);
+	for(int k=0; k!=mix.size(); ++k) {
+	  double ppt = fPairs.pt[k];
+	  double dist = fPairs.dist[k];
+	  float alpha = fPairs.alpha[k];
+	  if(ppt<fLoose.minPt || ppt>fLoose.maxPt || dist<fLoose.dist || alpha>fLoose.alpha) continue;
+	  unsigned int cuts = PairCuts(ppt,dist,alpha,cur.t[i],mix.t[k]);
+	  if(!cuts) continue;
+	  if(fQA && (cuts&1)) hPizeroMixMass[sc]->Fill( fPairs.m[k],ppt);
+	  fCandidates2->AddPxPyPzM( fPairs.px[k],fPairs.py[k],fPairs.pz[k],fPairs.m[k],sc,cuts );
+	}
+      }
     }
   }
 
+  // this event replaces the oldest of its pool; its arrays are swapped
+  // in, and the old ones are reused by the next event
+  if(binmix>=0 && fCurrent.clu.size()>0) PoolStore(binmix).swap( fCurrent );
+
   if(fQA) {
     for(int i=0; i!=8; ++i) {
       hNClu0->Fill( i, nclu0[i] );
@@ -235,28 +387,88 @@ void AT_PiZero::MyExec() {
   }
 }
 
-bool AT_PiZero::IsBad(int isc, int y, int z) {
-  bool ret = false;
+void AT_PiZero::SECTORCLU::clear() {
+  e.clear(); ux.clear(); uy.clear(); uz.clear();
+  x.clear(); y.clear(); z.clear(); t.clear();
+}
+
+void AT_PiZero::SECTORCLU::swap(SECTORCLU &o) {
+  e.swap(o.e); ux.swap(o.ux); uy.swap(o.uy); uz.swap(o.uz);
+  x.swap(o.x); y.swap(o.y); z.swap(o.z); t.swap(o.t);
+}
+
+void AT_PiZero::MIXEVENT::clear() {
+  clu.clear();
+  for(int s=0; s!=8; ++s) sector[s].clear();
+}
+
+void AT_PiZero::MIXEVENT::swap(MIXEVENT &o) {
+  clu.swap(o.clu);
+  for(int s=0; s!=8; ++s) sector[s].swap(o.sector[s]);
+}
 
-  // convert to veronica convention for sectors
-  int vSc = isc;
-  if(isc==6) vSc=7;
-  if(isc==7) vSc=6;
-  if(isc==4) vSc=5;
-  if(isc==5) vSc=4;
-  isc = vSc;
-  //
+void AT_PiZero::SECTORCLU::push(const FASTCLU &clu) {
+  double dl = TMath::Sqrt(clu.x*clu.x + clu.y*clu.y + clu.z*clu.z);
+  e.push_back(clu.ecore);
+  ux.push_back(clu.x/dl);
+  uy.push_back(clu.y/dl);
+  uz.push_back(clu.z/dl);
+  x.push_back(clu.x);
+  y.push_back(clu.y);
+  z.push_back(clu.z);
+  t.push_back(clu.t);
+}
+
+void AT_PiZero::Pairs(const SECTORCLU &a, int i, const SECTORCLU &b, int j0) {
+  // branch-free over plain arrays, so that the compiler vectorises it;
+  // m^2 = 2 e1 e2 (1-cos) = e1 e2 |u1-u2|^2 keeps small opening angles
+  int n = b.size()-j0;
+  if(n<=0) return;
+  if((int)fPairs.pt.size()<n) {
+    fPairs.px.resize(n); fPairs.py.resize(n); fPairs.pz.resize(n);
+    fPairs.pt.resize(n); fPairs.m.resize(n);
+    fPairs.dist.resize(n); fPairs.alpha.resize(n);
+  }
+  const double ei=a.e[i], uxi=a.ux[i], uyi=a.uy[i], uzi=a.uz[i];
+  const double xi=a.x[i], yi=a.y[i], zi=a.z[i];
+  const double *e=&b.e[j0], *ux=&b.ux[j0], *uy=&b.uy[j0], *uz=&b.uz[j0];
+  const double *x=&b.x[j0], *y=&b.y[j0], *z=&b.z[j0];
+  double *px=&fPairs.px[0], *py=&fPairs.py[0], *pz=&fPairs.pz[0];
+  double *pt=&fPairs.pt[0], *m=&fPairs.m[0], *dist=&fPairs.dist[0], *alpha=&fPairs.alpha[0];
+  for(int k=0; k<n; ++k) {
+    px[k] = ei*uxi + e[k]*ux[k];
+    py[k] = ei*uyi + e[k]*uy[k];
+    pz[k] = ei*uzi + e[k]*uz[k];
+    pt[k] = std::sqrt( px[k]*px[k] + py[k]*py[k] );
+    double dx = uxi-ux[k], dy = uyi-uy[k], dz = uzi-uz[k];
+    m[k] = std::sqrt( ei*e[k]*(dx*dx + dy*dy + dz*dz) );
+    double rx = xi-x[k], ry = yi-y[k], rz = zi-z[k];
+    dist[k] = std::sqrt( rx*rx + ry*ry + rz*rz );
+    alpha[k] = std::fabs(ei-e[k])/(ei+e[k]);
+  }
+}
 
-  if( y==0 || z==0 ) ret = true;
-  if( isc < 6 && ( y == 35 || z == 71) ) ret = true;
-  if( isc > 5 && ( y == 47 || z == 95) ) ret = true;
-  if( EMCMAP[isc][y-1][z-1] || EMCMAP[isc][y][z-1] || EMCMAP[isc][y+1][z-1] ||
-      EMCMAP[isc][y-1][z]   || EMCMAP[isc][y][z]   || EMCMAP[isc][y+1][z] ||
-      EMCMAP[isc][y-1][z+1] || EMCMAP[isc][y][z+1] || EMCMAP[isc][y+1][z+1] )
-    ret = true;
+unsigned int AT_PiZero::PairCuts(double pt, double dist, float alpha, float it, float jt) {
+  // one pass bit per cut set; the time cut applies to both clusters
+  float t = TMath::Max( fabs(it), fabs(jt) );
+  unsigned int ret = 0;
+  for(uint v=0; v!=fAllCuts.size(); ++v) {
+    const PI0CUTS &c = fAllCuts[v];
+    if(pt<c.minPt || pt>c.maxPt) continue;
+    if(dist<c.dist) continue;
+    if(alpha>c.alpha) continue;
+    if(t>c.time) continue;
+    ret |= (1u<<v);
+  }
   return ret;
 }
 
+void AT_PiZero::GoodClusters(const std::vector<int> &twrid, std::vector<unsigned int> &good) const {
+  good.clear();
+  for(uint i=0; i!=twrid.size(); ++i)
+    if(!IsBad(twrid[i])) good.push_back(i);
+}
+
 int AT_PiZero::P0_VertexBin(float vtx) {
   int ret = -1;
   float binning[21] = {-20,-18,-16,-14,-12,-10,-8.,-6.,-4.,-2., 0,
@@ -13,19 +13,42 @@ class AT_PiZero : public AT_ReadTree {
  public:
   AT_PiZero();
   virtual ~AT_PiZero();
+  virtual AnalysisTask* CloneTask() const {return new AT_PiZero(*this);}
+  virtual void MyBranches(std::vector<TString> &brs);
   virtual void MyInit();
   virtual void MyExec();
+  virtual bool MyHistory(bool selected);
+  virtual void EndHistory();
   virtual void MyFinish();
+  virtual void SaveState(TDirectory *dir);
+  virtual void LoadState(TDirectory *dir);
   void DoQA() {fQA=true;}
   void SetPt(float m, float M) {fCuts.minPt=m;fCuts.maxPt=M;}
   void SetDist(float val) {fCuts.dist=val;}
   void SetAlpha(float val) {fCuts.alpha=val;}
   void SetTime(float val) {fCuts.time=val;}
+  // extra pair-cut set evaluated in the same pair loop as the nominal one
+  // (max 31); candidates carry one pass bit per set, see Candidates::Cuts
+  void AddVariation(TString name, float dist, float alpha, float time);
+  // mixing pools per vertex (20) x centrality x psi2 bin, each keeping
+  // the last <depth> events; centrality bins split the selected range.
+  // With psi bins, events without a BBC plane are neither mixed nor pooled
+  void SetMixing(int depth, int ncen=1, int npsi=1)
+  {fMixDepth=depth; fMixCen=ncen; fMixPsi=npsi;}
 
  private:
-  bool IsBad(int sc, int y, int z);
+  enum {kNTowers=24768};
+  enum {kHistoryFactor=4}; // read back at most 4 x depth x bins entries
+  // warn-map tower or neighbour, or sector edge; one bit per tower id
+  bool IsBad(int twrid) const
+  {return twrid<0 || twrid>=kNTowers || (fBadTower[twrid>>5]>>(twrid&31))&1;}
+  // indices of the clusters whose tower is good
+  void GoodClusters(const std::vector<int> &twrid, std::vector<unsigned int> &good) const;
   int P0_VertexBin(float vtx);
-  int  EMCMAP[8][48][96];
+  bool PassEvent();
+  // good clusters of the event into fCurrent, counted per sector
+  void CurrentClusters(float vtxZ, int *nclu0, int *nclu1);
+  unsigned int fBadTower[kNTowers/32];
 
   bool fQA;
   TH1F *hVertex;
@@ -51,9 +74,48 @@ class AT_PiZero : public AT_ReadTree {
     float time;
   };
 
+  // clusters of one sector as parallel arrays: energy and unit vector
+  // for the pair kinematics, position and time for the cuts
+  struct SECTORCLU {
+    std::vector<double> e, ux, uy, uz, x, y, z, t;
+    void clear();
+    void push(const FASTCLU &clu);
+    int size() const {return e.size();}
+    void swap(SECTORCLU &o);
+  };
+  // one event as kept in a mixing pool
+  struct MIXEVENT {
+    std::vector<FASTCLU> clu; // as written into checkpoints
+    SECTORCLU sector[8];
+    void clear();
+    void swap(MIXEVENT &o);
+  };
+  // kinematics of cluster i of a against clusters j0.. of b
+  struct PAIRS {
+    std::vector<double> px, py, pz, pt, m, dist, alpha;
+  };
+  void Pairs(const SECTORCLU &a, int i, const SECTORCLU &b, int j0);
+
   PI0CUTS fCuts;
-  std::vector<FASTCLU> fPrevious[20]; //!
-  std::vector<FASTCLU> fBuffer; //!
+  std::vector<PI0CUTS> fVariations;
+  std::vector<TString> fVariationNames;
+  std::vector<PI0CUTS> fAllCuts; //! nominal + variations
+  PI0CUTS fLoose; //! loosest of fAllCuts, checked before PairCuts
+  unsigned int PairCuts(double pt, double dist, float alpha, float it, float jt);
+  int MixingBin(int bvtx, float cent); // -1: not mixed
+  MIXEVENT& PoolStore(int bin);
+  int fMixDepth;
+  int fMixCen;
+  int fMixPsi;
+  std::vector<MIXEVENT> fPool; //! [bin*fMixDepth+slot]
+  std::vector<int> fPoolFill; //! [bin] events held
+  std::vector<int> fPoolNext; //! [bin] slot overwritten next
+  std::vector<unsigned int> fGood; //!
+  MIXEVENT fCurrent; //!
+  std::vector<std::vector<MIXEVENT> > fHistory; //! [bin] newest first
+  int fHistoryOpen; //! bins of fHistory not yet full
+  Long64_t fHistoryRead; //! entries looked at for fHistory
+  PAIRS fPairs; //!
 };
 
 #endif
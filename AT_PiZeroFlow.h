@@ -7,6 +7,7 @@ class AT_PiZeroFlow : public AT_PiZero {
  public:
   AT_PiZeroFlow();
   virtual ~AT_PiZeroFlow();
+  virtual AnalysisTask* CloneTask() const {return new AT_PiZeroFlow(*this);}
   virtual void MyInit();
   virtual void MyExec();
   virtual void MyFinish();
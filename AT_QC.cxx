@@ -1,12 +1,23 @@
 #include <iostream>
-#include <TTree.h>
 #include <TMath.h>
 #include <TH1F.h>
-#include <TH2F.h>
+#include <TProfile.h>
 #include "Analysis.h"
+#include "QCumulant.h"
 #include "AT_QC.h"
 
 AT_QC::AT_QC() {
+  float ptbins[kNPt+1] = {0.4, 0.6, 0.8, 1.0, 1.2,
+			  1.4, 1.6, 1.8, 2.0, 2.5,
+			  3.0};
+  for(int i=0; i!=kNPt+1; ++i) fPtBins[i] = ptbins[i];
+  hMult = NULL;
+  hTwo = NULL;
+  hFour = NULL;
+  for(int n=0; n!=kNOrd; ++n) {
+    hTwoPrime[n] = NULL;
+    hFourPrime[n] = NULL;
+  }
 }
 
 AT_QC::~AT_QC() {
@@ -15,51 +26,96 @@ AT_QC::~AT_QC() {
 void AT_QC::Init() {
   Analysis *ana = Analysis::Instance();
   fCandidates = ana->GetCandidates();
-  for(int i=0; i!=4; ++i) fQ[i] = ana->GetQ(i);
-
-  float ptbins[11] = {0.4, 0.6, 0.8, 1.0, 1.2,
-                      1.4, 1.6, 1.8, 2.0, 2.5,
-                      3.0};
-
-  TProfile *fPQ_Cos[4];
-  for(int n=0; n!=4; ++n) {
-    fPxQx[n] = new TProfile( Form("P%dxQ%dx",i,i),
-			     Form("P_{%d,x}Q_{%d,x}",i,i),
-			     10,ptbins,"s");
-    fPyQy[n] = new TProfile( Form("P%dyQ%dy",i,i),
-			     Form("P_{%d,y}Q_{%d,y}",i,i),
-			     10,ptbins,"s");
-    fQxQx[n] = new TProfile( Form("Q%dxQ%dx",i,i),
-			     Form("Q_{%d,x}Q_{%d,x}",i,i),
-			     10,ptbins,"s");
-    fQyQy[n] = new TProfile( Form("Q%dyQ%dy",i,i),
-			     Form("Q_{%d,y}Q_{%d,y}",i,i),
-			     10,ptbins,"s");
+  hMult = new TH1F("hMult","Candidates;M",200,-0.5,199.5);
+  hTwo = new TProfile("hTwo","<<2>>;n",kNOrd,0.5,kNOrd+0.5);
+  hFour = new TProfile("hFour","<<4>>;n",kNOrd,0.5,kNOrd+0.5);
+  for(int n=0; n!=kNOrd; ++n) {
+    hTwoPrime[n] = new TProfile( Form("hTwoPrime%d",n+1),
+				 Form("<<2'>> n=%d;pt",n+1),
+				 kNPt,fPtBins );
+    hFourPrime[n] = new TProfile( Form("hFourPrime%d",n+1),
+				  Form("<<4'>> n=%d;pt",n+1),
+				  kNPt,fPtBins );
   }
 }
 
 void AT_QC::Finish() {
+  hMult->Write();
+  hTwo->Write();
+  hFour->Write();
+  for(int n=0; n!=kNOrd; ++n) {
+    hTwoPrime[n]->Write();
+    hFourPrime[n]->Write();
+  }
 }
 
 void AT_QC::Exec() {
-  uint npa = fCandidates->size();
-  //std::cout << "CANDIDATES " << npa <<std::endl;
-  //std::cout << "Q2.M " << fQ[1]->M() << std::endl;
-  if(npa==0) return;
-  for(int i=0; i!=4; ++i)
-    hQxQx[i]->Fill( fQ[i].X() * fQ[i].X() );
+  // default selection only; variations are not followed here
+  uint npa = 0;
+  for(uint i=0; i!=fCandidates->Size(); ++i)
+    if(fCandidates->Cuts(i)&1) ++npa;
+  if(npa<2) return;
+  hMult->Fill(npa);
 
-  qcQ u0(0);
-  qcQ u1(1);
-  qcQ u2(2);
-  qcQ u3(3);
-  for(int i=0; i!=npa; ++i) {
-    TLorentzVector a = fCandidates->at(i);
-    u0->Fill( a.Phi(), 1 );
-    u1->Fill( a.Phi(), 1 );
-    u2->Fill( a.Phi(), 1 );
-    u3->Fill( a.Phi(), 1 );
+  //====== Q and p vectors, one pass ======
+  for(int k=0; k!=kNHar; ++k) {
+    fQx[k] = fQy[k] = 0;
+    for(int b=0; b!=kNPt; ++b) fPx[b][k] = fPy[b][k] = 0;
+  }
+  for(int b=0; b!=kNPt; ++b) fMp[b] = 0;
+  double cn[kNHar], sn[kNHar];
+  for(uint i=0; i!=fCandidates->Size(); ++i) {
+    if( !(fCandidates->Cuts(i)&1) ) continue;
+    // cos, sin(k phi) by complex powers of one cos/sin
+    cn[0] = TMath::Cos( fCandidates->Phi(i) );
+    sn[0] = TMath::Sin( fCandidates->Phi(i) );
+    for(int k=1; k!=kNHar; ++k) {
+      cn[k] = cn[k-1]*cn[0] - sn[k-1]*sn[0];
+      sn[k] = sn[k-1]*cn[0] + cn[k-1]*sn[0];
+    }
+    for(int k=0; k!=kNHar; ++k) {
+      fQx[k] += cn[k];
+      fQy[k] += sn[k];
+    }
+    int b = BinPt( fCandidates->Pt(i) );
+    if(b<0) continue;
+    fMp[b] += 1;
+    for(int k=0; k!=kNHar; ++k) {
+      fPx[b][k] += cn[k];
+      fPy[b][k] += sn[k];
+    }
   }
 
+  //====== correlations ======
+  qcQ Q[kNHar];
+  for(int k=0; k!=kNHar; ++k) Q[k].SetXY( fQx[k], fQy[k], npa, npa );
+  double two[kNOrd];
+  for(int n=0; n!=kNOrd; ++n) { // harmonic n+1, Q2n at [2n+1]
+    double w;
+    two[n] = QCumulant::Two(Q[n],w);
+    if(w>0) hTwo->Fill( n+1, two[n], w );
+    double four = QCumulant::Four(Q[n],Q[2*n+1],w);
+    if(w>0) hFour->Fill( n+1, four, w );
+  }
+  for(int b=0; b!=kNPt; ++b) {
+    if(fMp[b]<1) continue;
+    double pt = 0.5*(fPtBins[b]+fPtBins[b+1]);
+    for(int n=0; n!=kNOrd; ++n) {
+      qcQ pn, p2n;
+      pn.SetXY( fPx[b][n], fPy[b][n], fMp[b], fMp[b] );
+      p2n.SetXY( fPx[b][2*n+1], fPy[b][2*n+1], fMp[b], fMp[b] );
+      double w;
+      double twop = QCumulant::TwoPrime(pn,Q[n],w);
+      if(w>0) hTwoPrime[n]->Fill( pt, twop, w );
+      double fourp = QCumulant::FourPrime(pn,p2n,Q[n],Q[2*n+1],w);
+      if(w>0) hFourPrime[n]->Fill( pt, fourp, w );
+    }
+  }
+}
 
+int AT_QC::BinPt(float pt) {
+  if( pt<fPtBins[0] || pt>=fPtBins[kNPt] ) return -1;
+  int b = 0;
+  while( pt>=fPtBins[b+1] ) ++b;
+  return b;
 }
@@ -2,21 +2,42 @@
 #define __AT_QC_HH__
 
 #include <vector>
-#include "AT_Charged.h"
+#include "AnalysisTask.h"
 
+class TH1F;
 class TProfile;
 
+// Q-cumulant flow of the candidates of the producer before it
+// (AT_Charged). The Q vectors of harmonics 1..8, for the event and per
+// pt bin, come from one pass over the candidates. <2>, <4> of n=1..4,
+// and <2'>, <4'> per pt bin, go into profiles with the event weights.
+// The profiles merge across threads and segments, and
+//  c{2} = <<2>>  c{4} = <<4>>-2<<2>>^2  v{2} = c{2}^1/2  v{4} = (-c{4})^1/4
+//  d{2} = <<2'>> d{4} = <<4'>>-2<<2'>><<2>>
+//  v'{2} = d{2}/c{2}^1/2  v'{4} = -d{4}/(-c{4})^3/4
+// are taken from the merged output.
 class AT_QC : public AnalysisTask {
  public:
   AT_QC();
   virtual ~AT_QC();
+  virtual AnalysisTask* CloneTask() const {return new AT_QC(*this);}
   virtual void Init();
   virtual void Exec();
   virtual void Finish();
 
  private:
-  TProfile *hd[4];
-  TProfile *hr[4];
+  enum {kNHar=8, kNOrd=4, kNPt=10};
+  int BinPt(float pt);
+
+  float fPtBins[kNPt+1];
+  double fQx[kNHar], fQy[kNHar];           // harmonic n at [n-1]
+  double fPx[kNPt][kNHar], fPy[kNPt][kNHar];
+  double fMp[kNPt];
+  TH1F *hMult;
+  TProfile *hTwo;  // <<2>> vs n
+  TProfile *hFour; // <<4>> vs n
+  TProfile *hTwoPrime[kNOrd];  // <<2'>> vs pt
+  TProfile *hFourPrime[kNOrd]; // <<4'>> vs pt
 };
 
 #endif
@@ -0,0 +1,62 @@
+#include <iostream>
+#include <TFile.h>
+#include <TTree.h>
+#include <TBranch.h>
+#include <TDirectory.h>
+#include "Analysis.h"
+#include "AT_QCache.h"
+
+AT_QCache::AT_QCache() : AT_ReadTree() {
+  SkipBBCQCal(); // selection only, no event planes needed
+  fFileName = "qcache.root";
+  fCompression = 101;
+  fFile = NULL;
+  fCache = NULL;
+}
+
+AT_QCache::~AT_QCache() {
+  if(fFile) delete fFile;
+}
+
+void AT_QCache::MyBranches(std::vector<TString> &brs) {
+  for(int i=0; i!=EventBuffers::kNQ; ++i)
+    brs.push_back( EventBuffers::QName(i) );
+}
+
+void AT_QCache::MyInit() {
+  Analysis *ana = Analysis::Instance();
+  TTree *tree = ana->GetTree();
+  if(!tree) return;
+  TString fname = fFileName;
+  if(fname.Contains("%s")) fname = Form(fFileName.Data(),ana->GetDataSetTag().Data());
+  int slot = ana->SlotNumber();
+  if(slot>0) fname.ReplaceAll(".root",Form("_slot%d.root",slot));
+  TDirectory::TContext ctx;
+  fFile = new TFile(fname.Data(),"RECREATE","",fCompression);
+  fFile->cd();
+  fCache = new TTree("QCACHE","Event and flat Q vectors");
+  // same Event layout as the input
+  fEvent->BranchQCache(fCache,tree->GetBranch("Event")->GetTitle());
+  std::cout << "AT_QCache::MyInit === writing into " << fname.Data() << std::endl;
+}
+
+void AT_QCache::MyExec() {
+  if(!fCache) return;
+  hEvents->Fill(2);
+  fEvent->Pack();
+  fCache->Fill();
+}
+
+void AT_QCache::MyFinish() {
+  if(!fFile) return;
+  TDirectory::TContext ctx;
+  fFile->cd();
+  fCache->Write();
+  std::cout << "AT_QCache::MyFinish === " << fCache->GetEntries() << " events, ";
+  std::cout << Form("%.0f B/event",fCache->GetEntries()>0 ? fCache->GetZipBytes()*1.0/fCache->GetEntries() : 0.0);
+  std::cout << " in " << fFile->GetName() << std::endl;
+  fFile->Close();
+  delete fFile;
+  fFile = NULL;
+  fCache = NULL;
+}
@@ -0,0 +1,33 @@
+#ifndef __AT_QCACHE_HH__
+#define __AT_QCACHE_HH__
+
+#include "AT_ReadTree.h"
+
+class TFile;
+class TTree;
+
+// Writes Event and the Q vectors (Q*ex, Q*fv, Q*bb) of the events
+// passing the AT_ReadTree event selection into a QCACHE tree of flat
+// float columns, a few hundred bytes per event with no object streaming.
+// Event-plane passes read it back with Analysis::QCacheInput().
+class AT_QCache : public AT_ReadTree {
+ public:
+  AT_QCache();
+  virtual ~AT_QCache();
+  virtual AnalysisTask* CloneTask() const {return new AT_QCache(*this);}
+  virtual void MyBranches(std::vector<TString> &brs);
+  virtual void MyInit();
+  virtual void MyExec();
+  virtual void MyFinish();
+  virtual bool CanCheckpoint() const {return false;} // Finish closes the file
+  void CacheFileName(TString name) {fFileName=name;} // %s: data set tag
+  void Compression(int val) {fCompression=val;} // 100*algorithm+level
+
+ private:
+  TString fFileName;
+  int fCompression;
+  TFile *fFile; //!
+  TTree *fCache; //!
+};
+
+#endif
@@ -8,6 +8,8 @@
 #include <TGraph.h>
 #include "Analysis.h"
 #include "AT_ReadTree.h"
+#include "Harmonics.h"
+#include "EPCorrection.h"
 
 AT_ReadTree::AT_ReadTree() : AnalysisTask() {
   // -20.0 ==> +20.0 (40+1)
@@ -23,82 +25,72 @@ AT_ReadTree::AT_ReadTree() : AnalysisTask() {
   fMask = kBBCnc | kBBCn;
   fCentralityMin = 0.0;
   fCentralityMax = 80.0;
-  for(int bce=0; bce!=fNBinsCen; ++bce) {
-    for(int bvt=0; bvt!=fNBinsVtx; ++bvt) {
-      for(int ord=0; ord!=6; ++ord) {
-	for(int se=0; se!=2; ++se) {
-	  bbcm[se][ord][0][bce][bvt] = 0.0;
-	  bbcm[se][ord][1][bce][bvt] = 0.0;
-	}
-      }
-      for(int ord=0; ord!=4; ++ord) {
-	for(int ior=0; ior!=32; ++ior) {
-	  bbcc[ior][ord][bce][bvt] = 0.0;
-	  bbcs[ior][ord][bce][bvt] = 0.0;
-	}
-      }
-    }
-  }
-  pMXSempc3x3 = new std::vector<Float_t>;
-  pQ1ex = new std::vector<qcQ>;
-  pQ2ex = new std::vector<qcQ>;
-  pQ3ex = new std::vector<qcQ>;
-  pQ4ex = new std::vector<qcQ>;
-  pQ6ex = new std::vector<qcQ>;
-  pQ8ex = new std::vector<qcQ>;
-  pQ1fv = new std::vector<qcQ>;
-  pQ2fv = new std::vector<qcQ>;
-  pQ3fv = new std::vector<qcQ>;
-  pQ1bb = new std::vector<qcQ>;
-  pQ2bb = new std::vector<qcQ>;
-  pQ3bb = new std::vector<qcQ>;
-  pQ4bb = new std::vector<qcQ>;
-  pQ6bb = new std::vector<qcQ>;
-  pQ8bb = new std::vector<qcQ>;
+  fCalibFile = "BBC_EPC/tables/calib.bin";
+  fCalib = NULL;
+  hEvents = NULL;
+  hCentrality0 = NULL;
+  fEvent = NULL;
+  fTracks = NULL;
+  pQ1ex = NULL;
+  pQ2ex = NULL;
+  pQ3ex = NULL;
+  pQ4ex = NULL;
+  pQ6ex = NULL;
+  pQ8ex = NULL;
+  pQ1fv = NULL;
+  pQ2fv = NULL;
+  pQ3fv = NULL;
+  pQ1bb = NULL;
+  pQ2bb = NULL;
+  pQ3bb = NULL;
+  pQ4bb = NULL;
+  pQ6bb = NULL;
+  pQ8bb = NULL;
 
-  pEMCid = new std::vector<Int_t>;
-  pEMCtwrid = new std::vector<Int_t>;
-  pEMCx = new std::vector<Float_t>;
-  pEMCy = new std::vector<Float_t>;
-  pEMCz = new std::vector<Float_t>;
-  pEMCecore = new std::vector<Float_t>;
-  pEMCecent = new std::vector<Float_t>;
-  pEMCchisq = new std::vector<Float_t>;
-  pEMCtimef = new std::vector<Float_t>;
+  pEMCid = NULL;
+  pEMCtwrid = NULL;
+  pEMCx = NULL;
+  pEMCy = NULL;
+  pEMCz = NULL;
+  pEMCecore = NULL;
+  pEMCecent = NULL;
+  pEMCchisq = NULL;
+  pEMCtimef = NULL;
 
-  pTRKqua = new std::vector<Int_t>;
-  pTRKpt = new std::vector<Float_t>;
-  pTRKphi = new std::vector<Float_t>;
-  pTRKpz = new std::vector<Float_t>;
-  pTRKecore = new std::vector<Float_t>;
-  pTRKetof = new std::vector<Float_t>;
-  pTRKtwrid = new std::vector<Int_t>;
-  pTRKplemc = new std::vector<Float_t>;
-  pTRKchisq = new std::vector<Float_t>;
-  pTRKdphi = new std::vector<Float_t>;
-  pTRKdz = new std::vector<Float_t>;
-  pTRKpc3sdphi = new std::vector<Float_t>;
-  pTRKpc3sdz = new std::vector<Float_t>;
-  pTRKzed = new std::vector<Float_t>;
-  pTRKdisp = new std::vector<Float_t>;
-  pTRKprob = new std::vector<Float_t>;
-  pTRKcid = new std::vector<Int_t>;
+  pTRKqua = NULL;
+  pTRKpt = NULL;
+  pTRKphi = NULL;
+  pTRKpz = NULL;
+  pTRKecore = NULL;
+  pTRKetof = NULL;
+  pTRKtwrid = NULL;
+  pTRKplemc = NULL;
+  pTRKchisq = NULL;
+  pTRKdphi = NULL;
+  pTRKdz = NULL;
+  pTRKpc3sdphi = NULL;
+  pTRKpc3sdz = NULL;
+  pTRKzed = NULL;
+  pTRKdisp = NULL;
+  pTRKprob = NULL;
+  pTRKcid = NULL;
 
-  pMXSempccent = new std::vector<Float_t>;
-  pMXSempc3x3 = new std::vector<Float_t>;
-  pMXSpt = new std::vector<Float_t>;
-  pMXSpz = new std::vector<Float_t>;
-  pMXSeta = new std::vector<Float_t>;
-  pMXSphi = new std::vector<Float_t>;
-  pMXSflyr = new std::vector<Int_t>;
-  pMXSsingleD = new std::vector<Float_t>;
-  pMXSsingleP = new std::vector<Int_t>;
+  pMXSempccent = NULL;
+  pMXSempc3x3 = NULL;
+  pMXSpt = NULL;
+  pMXSpz = NULL;
+  pMXSeta = NULL;
+  pMXSphi = NULL;
+  pMXSflyr = NULL;
+  pMXSsingleD = NULL;
+  pMXSsingleP = NULL;
 }
 
 void AT_ReadTree::Init() {
   Analysis *ana = Analysis::Instance();
   fCandidates = ana->GetCandidates();
   fCandidates2= ana->GetCandidates2();
+  fTracks = ana->GetTrackSelection();
   for(int i=0; i!=4; ++i) fQ[i] = ana->GetQ(i);
   hEvents = new TH1F("hEvents","hEvents",4,-0.5,3.5);
   hEvents->GetXaxis()->SetBinLabel(1,"AllEvents");
@@ -107,66 +99,63 @@ void AT_ReadTree::Init() {
 
   hCentrality0 = new TH1F("hCentrality0","hCentrality0",100,-0.5,99.5);
   
+  //Branch buffers are shared by all tasks of this event loop
   TTree *tree = ana->GetTree();
   if(!tree) {
     std::cout << "AT_ReadTree:Init says: Tree not found." << std::endl;
     return;
   }
-  //Opening assigning branches
-  tree->SetBranchAddress("Event",&fGLB);
-  //=
-  tree->SetBranchAddress("Q1ex",&pQ1ex);
-  tree->SetBranchAddress("Q2ex",&pQ2ex);
-  tree->SetBranchAddress("Q3ex",&pQ3ex);
-  tree->SetBranchAddress("Q4ex",&pQ4ex);
-  tree->SetBranchAddress("Q6ex",&pQ6ex);
-  tree->SetBranchAddress("Q8ex",&pQ8ex);
-  tree->SetBranchAddress("Q1fv",&pQ1fv);
-  tree->SetBranchAddress("Q2fv",&pQ2fv);
-  tree->SetBranchAddress("Q3fv",&pQ3fv);
-  tree->SetBranchAddress("Q1bb",&pQ1bb);
-  tree->SetBranchAddress("Q2bb",&pQ2bb);
-  tree->SetBranchAddress("Q3bb",&pQ3bb);
-  tree->SetBranchAddress("Q4bb",&pQ4bb);
-  tree->SetBranchAddress("Q6bb",&pQ6bb);
-  tree->SetBranchAddress("Q8bb",&pQ8bb);
-  //=
-  tree->SetBranchAddress("EMCid",   &pEMCid);
-  tree->SetBranchAddress("EMCtwrid",&pEMCtwrid);
-  tree->SetBranchAddress("EMCx",    &pEMCx);
-  tree->SetBranchAddress("EMCy",    &pEMCy);
-  tree->SetBranchAddress("EMCz",    &pEMCz);
-  tree->SetBranchAddress("EMCecore",&pEMCecore);
-  tree->SetBranchAddress("EMCecent",&pEMCecent);
-  tree->SetBranchAddress("EMCchisq",&pEMCchisq);
-  tree->SetBranchAddress("EMCtimef",&pEMCtimef);
-  //=
-  tree->SetBranchAddress("TRKqua",  &pTRKqua);
-  tree->SetBranchAddress("TRKpt",   &pTRKpt);
-  tree->SetBranchAddress("TRKphi",  &pTRKphi);
-  tree->SetBranchAddress("TRKpz",   &pTRKpz);
-  tree->SetBranchAddress("TRKecore",&pTRKecore);
-  tree->SetBranchAddress("TRKetof", &pTRKetof);
-  tree->SetBranchAddress("TRKplemc",&pTRKplemc);
-  tree->SetBranchAddress("TRKtwrid",&pTRKtwrid);
-  tree->SetBranchAddress("TRKchisq",&pTRKchisq);
-  tree->SetBranchAddress("TRKdphi", &pTRKdphi);
-  tree->SetBranchAddress("TRKdz",   &pTRKdz);
-  tree->SetBranchAddress("TRKpc3sdphi",&pTRKpc3sdphi);
-  tree->SetBranchAddress("TRKpc3sdz",  &pTRKpc3sdz);
-  tree->SetBranchAddress("TRKzed",  &pTRKzed);
-  tree->SetBranchAddress("TRKdisp", &pTRKdisp);
-  tree->SetBranchAddress("TRKprob", &pTRKprob);
-  tree->SetBranchAddress("TRKcid",  &pTRKcid);
-  //=
-  tree->SetBranchAddress("MXSpt",  &pMXSpt);
-  tree->SetBranchAddress("MXSpz",  &pMXSpz);
-  tree->SetBranchAddress("MXSphi", &pMXSphi);
-  tree->SetBranchAddress("MXSflyr",&pMXSflyr);
-  tree->SetBranchAddress("MXSsingleD", &pMXSsingleD);
-  tree->SetBranchAddress("MXSsingleP", &pMXSsingleP);
-  tree->SetBranchAddress("MXSempccent",&pMXSempccent);
-  tree->SetBranchAddress("MXSempc3x3", &pMXSempc3x3);
+  fEvent = ana->GetEvent();
+  pQ1ex = fEvent->pQ1ex;
+  pQ2ex = fEvent->pQ2ex;
+  pQ3ex = fEvent->pQ3ex;
+  pQ4ex = fEvent->pQ4ex;
+  pQ6ex = fEvent->pQ6ex;
+  pQ8ex = fEvent->pQ8ex;
+  pQ1fv = fEvent->pQ1fv;
+  pQ2fv = fEvent->pQ2fv;
+  pQ3fv = fEvent->pQ3fv;
+  pQ1bb = fEvent->pQ1bb;
+  pQ2bb = fEvent->pQ2bb;
+  pQ3bb = fEvent->pQ3bb;
+  pQ4bb = fEvent->pQ4bb;
+  pQ6bb = fEvent->pQ6bb;
+  pQ8bb = fEvent->pQ8bb;
+  pEMCid = fEvent->pEMCid;
+  pEMCtwrid = fEvent->pEMCtwrid;
+  pEMCx = fEvent->pEMCx;
+  pEMCy = fEvent->pEMCy;
+  pEMCz = fEvent->pEMCz;
+  pEMCecore = fEvent->pEMCecore;
+  pEMCecent = fEvent->pEMCecent;
+  pEMCchisq = fEvent->pEMCchisq;
+  pEMCtimef = fEvent->pEMCtimef;
+  pTRKqua = fEvent->pTRKqua;
+  pTRKpt = fEvent->pTRKpt;
+  pTRKphi = fEvent->pTRKphi;
+  pTRKpz = fEvent->pTRKpz;
+  pTRKecore = fEvent->pTRKecore;
+  pTRKetof = fEvent->pTRKetof;
+  pTRKtwrid = fEvent->pTRKtwrid;
+  pTRKplemc = fEvent->pTRKplemc;
+  pTRKchisq = fEvent->pTRKchisq;
+  pTRKdphi = fEvent->pTRKdphi;
+  pTRKdz = fEvent->pTRKdz;
+  pTRKpc3sdphi = fEvent->pTRKpc3sdphi;
+  pTRKpc3sdz = fEvent->pTRKpc3sdz;
+  pTRKzed = fEvent->pTRKzed;
+  pTRKdisp = fEvent->pTRKdisp;
+  pTRKprob = fEvent->pTRKprob;
+  pTRKcid = fEvent->pTRKcid;
+  pMXSempccent = fEvent->pMXSempccent;
+  pMXSempc3x3 = fEvent->pMXSempc3x3;
+  pMXSpt = fEvent->pMXSpt;
+  pMXSpz = fEvent->pMXSpz;
+  pMXSeta = fEvent->pMXSeta;
+  pMXSphi = fEvent->pMXSphi;
+  pMXSflyr = fEvent->pMXSflyr;
+  pMXSsingleD = fEvent->pMXSsingleD;
+  pMXSsingleP = fEvent->pMXSsingleP;
   LoadTableEP();
 
   MyInit();
@@ -187,8 +176,8 @@ void AT_ReadTree::CheckEP1() {
     runs[ir] = run;
     for(int se=0; se!=2; ++se) {
       for(int ord=0; ord!=6; ++ord) {
-	bbcqx[se][ord][ir] = bbcm[se][ord][0][2][20]; // bce=2 bvtx=20
-	bbcqy[se][ord][ir] = bbcm[se][ord][1][2][20]; // bce=2 bvtx=20
+	bbcqx[se][ord][ir] = fCalib->Cell(2,20).m[se][ord][0]; // bce=2 bvtx=20
+	bbcqy[se][ord][ir] = fCalib->Cell(2,20).m[se][ord][1]; // bce=2 bvtx=20
       }
     }
   }
@@ -235,8 +224,8 @@ void AT_ReadTree::CheckEP2() {
     runs[ir] = run;
     for(int se=0; se!=32; ++se) {
       for(int ord=0; ord!=4; ++ord) {
-	bbcqc[se][ord][ir] = bbcc[se][ord][3][20]; // bce=2 bvtx=20
-	bbcqs[se][ord][ir] = bbcs[se][ord][3][20]; // bce=2 bvtx=20
+	bbcqc[se][ord][ir] = fCalib->Cell(3,20).c[ord][se]; // bce=3 bvtx=20
+	bbcqs[se][ord][ir] = fCalib->Cell(3,20).s[ord][se]; // bce=3 bvtx=20
       }
     }
   }
@@ -292,8 +281,31 @@ AT_ReadTree::~AT_ReadTree() {
   if(hCentrality0) delete hCentrality0;
 }
 
+void AT_ReadTree::Branches(std::vector<TString> &brs) {
+  brs.push_back("Event");
+  if(fBBCQCal) {
+    brs.push_back("Q1bb");
+    brs.push_back("Q2bb");
+    brs.push_back("Q3bb");
+    brs.push_back("Q4bb");
+  }
+  MyBranches(brs);
+}
+
 void AT_ReadTree::Exec() {
+  fGLB = fEvent->fGLB;
   hEvents->Fill(0);
+  if(!Select(true)) return;
+  MyExec();
+}
+
+bool AT_ReadTree::History() {
+  fGLB = fEvent->fGLB;
+  return MyHistory( Select(false) );
+}
+
+// event cuts and event planes; <fill> books the event in the histograms
+bool AT_ReadTree::Select(bool fill) {
   float vtx = fGLB.vtxZ;
   float cen = fGLB.cent;
   unsigned int trigger = fGLB.trig;
@@ -301,113 +313,59 @@ void AT_ReadTree::Exec() {
   if(trigger & fMask) trig = true;
   float frac = fGLB.frac;
 
-  if(cen<0.5||cen>60.5) return;
-  if(cen<fCentralityMin||cen>fCentralityMax) return;
-  if(!trig) return;
-  if(frac<0.95) return;
-  if(TMath::Abs(vtx)>20) return;
+  if(cen<0.5||cen>60.5) return false;
+  if(cen<fCentralityMin||cen>fCentralityMax) return false;
+  if(!trig) return false;
+  if(frac<0.95) return false;
+  if(TMath::Abs(vtx)>20) return false;
   //std::cout << " " << cen << " " << frac << " " << vtx << std::endl;
 
   int bvtx = BinVertex( vtx );
   int bcen = BinCentrality( cen );
   //std::cout << "  " << bcen << " " << bvtx << std::endl;
 
-  if(bvtx<0 || bcen<0) return;
-  hEvents->Fill(1);
-  hCentrality0->Fill(cen);
+  if(bvtx<0 || bcen<0) return false;
+  if(fill) {
+    hEvents->Fill(1);
+    hCentrality0->Fill(cen);
+  }
 
   if(fBBCQCal) MakeBBCEventPlanes(bcen,bvtx);
-  MyExec();
+  return true;
 }
 
 //BBC EVENTPLANE
 void AT_ReadTree::MakeBBCEventPlanes(int bcen, int bvtx) {
-  Psi_BBC;
+  Psi_BBC = true;
   Psi1_BBC = 0;
   Psi2_BBC = 0;
   Psi3_BBC = 0;
   Psi4_BBC = 0;
-  qcQ qvec[4][3];
+  EPCorrection<EPCell,2> epc;
   for(int se=0; se!=2; ++se) {
-    qvec[0][se] = pQ1bb->at(se);
-    qvec[1][se] = pQ2bb->at(se);
-    qvec[2][se] = pQ3bb->at(se);
-    qvec[3][se] = pQ4bb->at(se);
-    if(qvec[0][se].M()<1) {
+    if(pQ1bb->at(se).M()<1) {
       Psi_BBC = false;
       return;
     }
+    epc.Load(0,se,pQ1bb->at(se));
+    epc.Load(1,se,pQ2bb->at(se));
+    epc.Load(2,se,pQ3bb->at(se));
+    epc.Load(3,se,pQ4bb->at(se));
   }
 
-  // ======= STAGE 2: Recentering SubEvents (STEP1)  =======
-  for(int k=0; k!=4; ++k) { // order
-    for(int j=0; j!=2; ++j) { // subevent
-      double x = qvec[k][j].X();
-      double y = qvec[k][j].Y();
-      double cn = bbcm[j][k][0][bcen][bvtx];
-      double sn = bbcm[j][k][1][bcen][bvtx];
-      qvec[k][j].SetXY( x - cn, y - sn, qvec[k][j].NP(), qvec[k][j].M() );
-    }
-  }
-
-  int twon[4] = {1,3,4,5}; // 1,2,3,4,6,8
-  // ======= STAGE 4: Twisting SubEvents (STEP2)  =======
-  for(int k=0; k!=4; ++k) { // order
-    for(int j=0; j!=2; ++j) { // subevent
-      double x = qvec[k][j].X();
-      double y = qvec[k][j].Y();
-      double c2n = bbcm[j][twon[k]][0][bcen][bvtx] / qvec[k][j].M();
-      double s2n = bbcm[j][twon[k]][1][bcen][bvtx] / qvec[k][j].M();
-      double ldaSm = s2n/(1.0+c2n);
-      double ldaSp = s2n/(1.0-c2n);
-      double den = 1.0 - ldaSm*ldaSp;
-      qvec[k][j].SetXY( (x-ldaSm*y) / den,
-                        (y-ldaSp*x) / den,
-                        qvec[k][j].NP(),
-                        qvec[k][j].M() );
-      if( TMath::IsNaN( qvec[k][j].X() ) || TMath::IsNaN( qvec[k][j].Y() ) ) {
-	std::cout << "Error building coefficient ";
-	std::cout << " | qvec.M: " << qvec[k][j].M();
-	std::cout << " | c2n: " << c2n;
-	std::cout << " | s2n: " << s2n;
-	std::cout << " | ldaSm: " << ldaSm;
-	std::cout << " | ldaSp: " << ldaSp;
-	std::cout << " | den: " << den << std::endl;
-      }
-    }
-  }
-
-  // ======= STAGE 6: Rescaling SubEvents (STEP3)  =======
-  for(int k=0; k!=4; ++k) { // order
-    for(int j=0; j!=2; ++j) { // subevent
-      double x = qvec[k][j].X();
-      double y = qvec[k][j].Y();
-      double c2n = bbcm[j][twon[k]][0][bcen][bvtx] / qvec[k][j].M();
-      double a2np = 1.0+c2n;
-      double a2nm = 1.0-c2n;
-      qvec[k][j].SetXY( x / a2np,
-                        y / a2nm,
-                        qvec[k][j].NP(),
-                        qvec[k][j].M() );
-      if( TMath::IsNaN( qvec[k][j].X() ) || TMath::IsNaN( qvec[k][j].Y() ) ) {
-	std::cout << "Error building coefficient [2] ";
-	std::cout << " | a2np: " << a2np;
-	std::cout << " | a2nm: " << a2nm << std::endl;
-      }
-    }
-  }
+  // ======= STAGES 2-6: Recentering, Twisting and Rescaling SubEvents =======
+  const EPCell &cell = fCalib->Cell(bcen,bvtx);
+  epc.Correct(cell);
 
-  // ======= STAGE 8: Bulding Full Q and Storing Flattening Coeficients  =======
+  // ======= STAGE 8: Bulding Full Q and Flattening =======
   double delta[4] = {0,0,0,0};
+  double psi[4];
+  double cosn[Harmonics::kN], sinn[Harmonics::kN];
   for(int k=0; k!=4; ++k) { // order
-    qvec[k][2] = qvec[k][0] + qvec[k][1];
-    double psi = qvec[k][2].Psi2Pi();
-    for(int ik=0; ik!=32; ++ik) { // correction order
-      int nn = ik+1;
-      delta[k] -= TMath::Cos(nn*psi)*bbcs[ik][k][bcen][bvtx]*2.0/nn;
-      delta[k] += TMath::Sin(nn*psi)*bbcc[ik][k][bcen][bvtx]*2.0/nn;
-    }
-    fQ[k]->CopyFrom( qvec[k][2] );
+    qcQ full = epc.Full(k);
+    psi[k] = full.Psi2Pi();
+    delta[k] = EPCorrection<EPCell,2>::Flatten(cell,k,psi[k],cosn,sinn);
+    fQ[k]->CopyFrom( full );
     double cn = TMath::Cos( (k+1)*delta[k] );
     double sn = TMath::Sin( (k+1)*delta[k] );
     double xprime = fQ[k]->X()*cn - fQ[k]->Y()*sn;
@@ -415,10 +373,10 @@ void AT_ReadTree::MakeBBCEventPlanes(int bcen, int bvtx) {
     fQ[k]->SetXY( xprime, yprime, fQ[k]->NP(),fQ[k]->M() );
   }
 
-  Psi1_BBC = qvec[0][2].Psi2Pi()+delta[0];
-  Psi2_BBC = qvec[1][2].Psi2Pi()+delta[1];
-  Psi3_BBC = qvec[2][2].Psi2Pi()+delta[2];
-  Psi4_BBC = qvec[3][2].Psi2Pi()+delta[3];
+  Psi1_BBC = psi[0]+delta[0];
+  Psi2_BBC = psi[1]+delta[1];
+  Psi3_BBC = psi[2]+delta[2];
+  Psi4_BBC = psi[3]+delta[3];
 
   /*
   if( (TMath::Abs( fQ[0]->Psi2Pi() - Psi1_BBC ) < 1e-4) ||
@@ -431,20 +389,7 @@ void AT_ReadTree::MakeBBCEventPlanes(int bcen, int bvtx) {
 }
 
 int AT_ReadTree::ReferenceTracks() {
-  int ntrk=0;
-  uint ntrks = pTRKpt->size();
-  for(uint itrk=0; itrk!=ntrks; ++itrk) {
-    float zed  = pTRKzed->at(itrk);
-    int qua = pTRKqua->at(itrk);
-    float dphi = pTRKpc3sdphi->at(itrk);
-    float dz   = pTRKpc3sdz->at(itrk);
-    if(qua!=63) continue;
-    if(TMath::Abs(zed)<3||TMath::Abs(zed)>70) continue;
-    if(TMath::Abs(dphi)>3) continue;
-    if(TMath::Abs(dz)>3) continue;
-    ntrk++;
-  }
-  return ntrk;
+  return fTracks->Selected().size();
 }
 int AT_ReadTree::BinVertex(float vtx) {
   int ret=-1;
@@ -475,35 +420,7 @@ void AT_ReadTree::LoadTableEP( int run ) {
   }
   std::cout << " RUN " << run << std::endl;
 
-  ifstream fin;
-  int se, ord, xy, bce, bvt;
-  float tmp;
-  fin.open( Form("BBC_EPC/tables/BBC_%d.dat",run) );
-  int nn=0;
-  for(;;++nn) {
-    fin >> tmp;
-    if(!fin.good()) break;
-    int ord = (nn/9600)%6;
-    int xy = (nn/4800)%2;
-    int se = (nn/2400)%2;
-    int bce = (nn/40)%60;
-    int bvt = nn%40;
-    bbcm[se][ord][xy][bce][bvt] = tmp*1e-1;
-  }
-  fin.close();
-  std::cout << "   BBC ReCenter coefficients loaded: " << nn << std::endl;
-  fin.open( Form("BBC_EPC/tables/BBC_A_%d.dat",run) );
-  nn=0;
-  for(;;++nn) {
-    fin >> tmp;
-    if(!fin.good()) break;
-    int ord = (nn/153600)%4;
-    int bce = (nn/2560)%60;
-    int bcs = (nn/1280)%2;
-    int bor = (nn/40)%32;
-    int bvt = nn%40;
-    if(bcs==0) bbcc[bor][ord][bce][bvt] = tmp*1e-3;
-    else bbcs[bor][ord][bce][bvt] = tmp*1e-3;
-  }
-  std::cout << "   BBC Flattening coefficients loaded: " << nn << std::endl;
+  fCalib = CalibStore::Get( fCalibFile, "BBC_EPC/tables", run );
+  if(!(fCalib->Parts()&CalibStore::kRecenter)) std::cout << "   no BBC ReCenter coefficients for run " << run << std::endl;
+  if(!(fCalib->Parts()&CalibStore::kFlat)) std::cout << "   no BBC Flattening coefficients for run " << run << std::endl;
 }
@@ -6,17 +6,28 @@
 #include <TH1F.h>
 #include "qcQ.h"
 #include "AnalysisTask.h"
+#include "EventBuffers.h"
+#include "CalibStore.h"
+#include "TrackSelection.h"
 
 class AT_ReadTree : public AnalysisTask {
  public:
   AT_ReadTree();
   virtual ~AT_ReadTree();
+  virtual AnalysisTask* CloneTask() const {return new AT_ReadTree(*this);}
   virtual void Init();
   virtual void Exec();
   virtual void Finish();
+  virtual void InitRun(int run) {LoadTableEP(run);}
+  virtual void Branches(std::vector<TString> &brs);
+  virtual void MyBranches(std::vector<TString> &brs) {brs.push_back("*");}
   virtual void MyInit() {}
   virtual void MyFinish() {}
   virtual void MyExec() {}
+  // see AnalysisTask::History; MyHistory is told whether the event
+  // passes the event cuts, in which case its event planes are set
+  virtual bool History();
+  virtual bool MyHistory(bool) {return false;}
   void CheckEP1();
   void CheckEP2();
   int ReferenceTracks();
@@ -24,8 +35,10 @@ class AT_ReadTree : public AnalysisTask {
   void TriggerMask(unsigned int msk) {fMask=msk;}
   void CentralitySelection(float min, float max)
   {fCentralityMin=min; fCentralityMax=max;}
+  void CalibrationStore(TString file) {fCalibFile=file;}
 
  private:
+  bool Select(bool fill);
   void MakeBBCEventPlanes(int,int);
   void LoadTableEP(int run=-1);
 
@@ -50,21 +63,13 @@ class AT_ReadTree : public AnalysisTask {
   float Psi2_BBC;
   float Psi3_BBC;
   float Psi4_BBC;
-  float bbcm[2][6][2][60][40]; //se ord xy bcen bvtx
-  float bbcc[32][4][60][40]; //har ord bcen bvtx
-  float bbcs[32][4][60][40]; //har ord bcen bvtx
-  float fMXm[8][6][2][60][40]; //se ord xy bcen bvtx
-  float fMXc[32][4][60][40]; //har ord bcen bvtx
-  float fMXs[32][4][60][40]; //har ord bcen bvtx
+  TString fCalibFile;
+  const EPCalib *fCalib; // of the current run, shared, see CalibStore
 
-  typedef struct MyTreeRegister {
-    Float_t vtxZ;
-    Float_t cent;
-    Float_t bbcs;
-    Float_t frac;
-    UInt_t  trig;
-  } MyTreeRegister_t;
-  MyTreeRegister_t fGLB;
+  EventBuffers *fEvent;
+  EventBuffers::MyTreeRegister_t fGLB;
+
+  TrackSelection *fTracks; // shared by the tasks of the event loop
 
   std::vector<qcQ> *pQ1ex;
   std::vector<qcQ> *pQ2ex;
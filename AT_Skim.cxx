@@ -0,0 +1,81 @@
+#include <iostream>
+#include <TFile.h>
+#include <TTree.h>
+#include <TChain.h>
+#include <TBranch.h>
+#include <TObjArray.h>
+#include <TDirectory.h>
+#include "Analysis.h"
+#include "AT_Skim.h"
+
+AT_Skim::AT_Skim() : AT_ReadTree() {
+  SkipBBCQCal(); // selection only, no event planes needed
+  fFileName = "skim.root";
+  fCompression = 101;
+  fFile = NULL;
+  fSkim = NULL;
+}
+
+AT_Skim::~AT_Skim() {
+  if(fFile) delete fFile;
+}
+
+void AT_Skim::MyBranches(std::vector<TString> &brs) {
+  if(fKeep.size()==0) {
+    brs.push_back("*");
+    return;
+  }
+  for(uint i=0; i!=fKeep.size(); ++i)
+    brs.push_back( fKeep[i] );
+}
+
+void AT_Skim::MyInit() {
+  Analysis *ana = Analysis::Instance();
+  TTree *tree = ana->GetTree();
+  if(!tree) return;
+  TString fname = fFileName;
+  if(fname.Contains("%s")) fname = Form(fFileName.Data(),ana->GetDataSetTag().Data());
+  int slot = ana->SlotNumber();
+  if(slot>0) fname.ReplaceAll(".root",Form("_slot%d.root",slot));
+  TDirectory::TContext ctx;
+  fFile = new TFile(fname.Data(),"RECREATE","",fCompression);
+  fFile->cd();
+  // other tasks may have switched on more branches than we keep: clone
+  // with only ours active, then give the input its branches back
+  std::vector<TString> on;
+  TObjArray *brs = tree->GetListOfBranches();
+  for(int ib=0; ib!=brs->GetEntries(); ++ib) {
+    TString name = ((TBranch*) brs->At(ib))->GetName();
+    if(tree->GetBranchStatus(name.Data())) on.push_back(name);
+  }
+  if(fKeep.size()>0) {
+    tree->SetBranchStatus("*",0);
+    tree->SetBranchStatus("Event",1);
+    for(uint i=0; i!=fKeep.size(); ++i)
+      tree->SetBranchStatus(fKeep[i].Data(),1);
+  }
+  fSkim = tree->CloneTree(0);
+  for(uint i=0; i!=on.size(); ++i)
+    tree->SetBranchStatus(on[i].Data(),1);
+  std::cout << "AT_Skim::MyInit === writing " << fSkim->GetListOfBranches()->GetEntries();
+  std::cout << " branches into " << fname.Data() << std::endl;
+}
+
+void AT_Skim::MyExec() {
+  if(!fSkim) return;
+  hEvents->Fill(2);
+  fSkim->Fill();
+}
+
+void AT_Skim::MyFinish() {
+  if(!fFile) return;
+  TDirectory::TContext ctx;
+  fFile->cd();
+  fSkim->Write();
+  std::cout << "AT_Skim::MyFinish === " << fSkim->GetEntries() << " events kept in ";
+  std::cout << fFile->GetName() << std::endl;
+  fFile->Close();
+  delete fFile;
+  fFile = NULL;
+  fSkim = NULL;
+}
@@ -0,0 +1,35 @@
+#ifndef __AT_SKIM_HH__
+#define __AT_SKIM_HH__
+
+#include <vector>
+#include "AT_ReadTree.h"
+
+class TFile;
+class TTree;
+
+// Copies the events passing the AT_ReadTree event selection, with only
+// the kept branches, into a TOP tree of its own file. The skim can be
+// read back by Analysis like any other input.
+class AT_Skim : public AT_ReadTree {
+ public:
+  AT_Skim();
+  virtual ~AT_Skim();
+  virtual AnalysisTask* CloneTask() const {return new AT_Skim(*this);}
+  virtual void MyBranches(std::vector<TString> &brs);
+  virtual void MyInit();
+  virtual void MyExec();
+  virtual void MyFinish();
+  virtual bool CanCheckpoint() const {return false;} // Finish closes the skim
+  void SkimFileName(TString name) {fFileName=name;} // %s: data set tag
+  void Compression(int val) {fCompression=val;} // 100*algorithm+level
+  void KeepBranch(TString name) {fKeep.push_back(name);}
+
+ private:
+  TString fFileName;
+  int fCompression;
+  std::vector<TString> fKeep;
+  TFile *fFile; //!
+  TTree *fSkim; //!
+};
+
+#endif
@@ -1,11 +1,28 @@
 #include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <cstdio>
 #include <vector>
+#include <thread>
+#include <typeinfo>
+#include <cxxabi.h>
+#include <time.h>
 
+#include <TROOT.h>
+#include <TSystem.h>
 #include <TString.h>
 #include <TList.h>
 #include <TFile.h>
+#include <TDirectory.h>
+#include <TMemFile.h>
+#include <TFileMerger.h>
 #include <TH2F.h>
 #include <TTree.h>
+#include <TChain.h>
+#include <TBranch.h>
+#include <TTreeCache.h>
+#include <TTreeCacheUnzip.h>
+#include <TH1.h>
 #include <TObjArray.h>
 #include <TObjString.h>
 #include <TLorentzVector.h>
@@ -16,91 +33,654 @@
 Analysis *Analysis::fAnalysis = NULL;
 
 
-Analysis::Analysis() {
-  fInputFileName = "input.root";
-  fOutputFileName = "output.root";
-  fNoSkipEventsAtBeginning=0;
-  fNoEventsAnalyzed=-1;
+Analysis::Slot::Slot() {
   fListOfTasks = new TList();
   fListOfTasks->SetOwner();
-  fInputFile = NULL;
   fTree = NULL;
-  fCandidates = new std::vector<TLorentzVector>;
-  fCandidates2 = new std::vector<TLorentzVector>;
+  fEvent = new EventBuffers();
+  fTracks = new TrackSelection(fEvent);
+  fTreeNumber = -1;
+  fRun = -1;
+  fCandidates = new Candidates();
+  fCandidates2 = new Candidates();
   for(int i=0; i!=4; ++i)
     fQ[i] = new qcQ(i+1);
+  fFirstEntry = 0;
+  fLastEntry = 0;
+  fRangeFirst = 0;
 }
 //=====
-Analysis::~Analysis() {
+Analysis::Slot::~Slot() {
   delete fListOfTasks;
-  if(fInputFile) delete fInputFile;
+  if(fTree) delete fTree;
+  delete fTracks;
+  delete fEvent;
   delete fCandidates;
   delete fCandidates2;
   for(int i=0; i!=4; ++i)
     delete fQ[i];
 }
 //=====
+Analysis::Analysis() {
+  fInputFileName = "input.root";
+  fOutputFileName = "output.root";
+  fNoSkipEventsAtBeginning=0;
+  fNoEventsAnalyzed=-1;
+  fNThreads = 1;
+  fCacheSize = 0;
+  fQCache = false;
+  fParallelUnzip = false;
+  fTiming = true;
+  fCheckpointEvery = 0;
+  fExecWall = 0;
+  fSlot = new Slot();
+  fSlots.push_back( fSlot );
+  fListOfTasks = fSlot->fListOfTasks;
+}
+//=====
+Analysis::~Analysis() {
+  for(uint i=0; i!=fSlots.size(); ++i)
+    delete fSlots[i];
+}
+//=====
 void Analysis::Init() {
   std::cout << "** Analysis::Init() **" << std::endl;
-  std::cout << " Reading from file " << fInputFileName.Data() << std::endl;
-  fInputFile = new TFile(fInputFileName.Data(),"READ");
-  if(!fInputFile) return;
-  fTree = (TTree*) fInputFile->Get("TOP");
-  if(!fTree) {
+  if(fInputFiles.size()==0) fInputFiles.push_back( fInputFileName );
+  if(fDSTag.Length()==0) fDSTag = TagOfFile( fInputFiles[0] );
+  // histograms are written explicitly by the tasks, keep them out of
+  // whatever file the chain happens to have open
+  TH1::AddDirectory(kFALSE);
+  if(fParallelUnzip) {
+    // has to be set before any cache is created
+    ROOT::EnableImplicitMT();
+    TTreeCacheUnzip::SetParallelUnzip(TTreeCacheUnzip::kEnable);
+  }
+  TFile::SetFileBytesRead(0);
+  TFile::SetFileReadCalls(0);
+  if(fCheckpointEvery>0) {
+    for(int i=0; i!=fListOfTasks->GetEntries(); ++i) {
+      AnalysisTask *tsk = (AnalysisTask*) fListOfTasks->At(i);
+      if(tsk->CanCheckpoint()) continue;
+      std::cout << " Task " << i << " cannot be checkpointed, checkpoints are off." << std::endl;
+      fCheckpointEvery = 0;
+      break;
+    }
+  }
+  if(fNThreads>1) {
+    ROOT::EnableThreadSafety();
+    // clones are taken before Init so that they start from the user settings
+    for(int ith=1; ith<fNThreads; ++ith) {
+      Slot *slot = new Slot();
+      int ntsk = fListOfTasks->GetEntries();
+      for(int i=0; i!=ntsk; ++i) {
+	AnalysisTask *tsk = (AnalysisTask*) fListOfTasks->At(i);
+	AnalysisTask *cln = tsk->CloneTask();
+	if(!cln) {
+	  std::cout << " Task " << i << " cannot be cloned." << std::endl;
+	  break;
+	}
+	slot->fListOfTasks->Add(cln);
+      }
+      if(slot->fListOfTasks->GetEntries()!=ntsk) {
+	delete slot;
+	std::cout << " Running with " << fSlots.size() << " thread(s)." << std::endl;
+	break;
+      }
+      fSlots.push_back( slot );
+    }
+  }
+  for(uint i=0; i!=fSlots.size(); ++i)
+    InitSlot( fSlots[i] );
+  fSlot = fSlots[0];
+}
+//=====
+void Analysis::InitSlot(Slot *slot) {
+  fSlot = slot;
+  slot->fTaskTime.assign(slot->fListOfTasks->GetEntries()*kNStages,Timer());
+  slot->fTree = new TChain(fQCache ? "QCACHE" : "TOP");
+  for(uint i=0; i!=fInputFiles.size(); ++i) {
+    if(slot==fSlots[0])
+      std::cout << " Reading from file " << fInputFiles[i].Data() << std::endl;
+    slot->fTree->Add( fInputFiles[i].Data() );
+  }
+  if(slot->fTree->GetEntries()<1) {
     std::cout << " No Tree found!!" << std::endl;
+    delete slot->fTree;
+    slot->fTree = NULL;
     return;
   }
+  slot->fRun = RunNumber();
+  SelectBranches(slot);
+  slot->fEvent->Connect(slot->fTree);
+  SetupCache(slot);
   //---
-  int ntsk = fListOfTasks->GetEntries();
+  int ntsk = slot->fListOfTasks->GetEntries();
+  double wall, cpu;
+  Lap(NULL,wall,cpu);
   for(int i=0; i!=ntsk; ++i) {
-    AnalysisTask *tsk = (AnalysisTask*) fListOfTasks->At(i);
+    AnalysisTask *tsk = (AnalysisTask*) slot->fListOfTasks->At(i);
     tsk->Init();
+    Lap(&slot->fTaskTime[i*kNStages+kInit],wall,cpu);
+  }
+}
+//=====
+void Analysis::SelectBranches(Slot *slot) {
+  std::vector<TString> brs;
+  int ntsk = slot->fListOfTasks->GetEntries();
+  for(int i=0; i!=ntsk; ++i) {
+    AnalysisTask *tsk = (AnalysisTask*) slot->fListOfTasks->At(i);
+    tsk->Branches(brs);
+  }
+  // nothing declared: read (and cache) everything
+  if(brs.size()==0) brs.push_back("*");
+  // EventBuffers::Connect needs the globals of every event
+  bool glb = false;
+  for(uint i=0; i!=brs.size(); ++i)
+    if(brs[i]=="Event") glb = true;
+  if(!glb) brs.push_back("Event");
+  if(fQCache) {
+    // sub-event counts of the flat Q columns
+    brs.push_back("nex");
+    brs.push_back("nfv");
+    brs.push_back("nbb");
+  }
+  slot->fBranches = brs;
+  for(uint i=0; i!=brs.size(); ++i)
+    if(brs[i]=="*") return; // somebody still reads everything
+  slot->fTree->SetBranchStatus("*",0);
+  for(uint i=0; i!=brs.size(); ++i)
+    slot->fTree->SetBranchStatus(brs[i].Data(),1);
+  if(slot==fSlots[0]) {
+    std::cout << " Reading branches:";
+    for(uint i=0; i!=brs.size(); ++i) std::cout << " " << brs[i].Data();
+    std::cout << std::endl;
+  }
+}
+//=====
+void Analysis::SetupCache(Slot *slot) {
+  if(fCacheSize<=0) return;
+  slot->fTree->SetCacheSize(fCacheSize);
+  // no learning phase: the cache holds exactly the declared branches
+  // (SelectBranches turns an empty list into "*")
+  for(uint i=0; i!=slot->fBranches.size(); ++i)
+    slot->fTree->AddBranchToCache(slot->fBranches[i].Data(),kTRUE);
+  slot->fTree->StopCacheLearningPhase();
+}
+//=====
+void Analysis::ReportIO() {
+  std::cout << " ** I/O summary **" << std::endl;
+  Long64_t bytes = TFile::GetFileBytesRead();
+  int calls = TFile::GetFileReadCalls();
+  std::cout << "  Bytes read " << bytes << " in " << calls << " calls";
+  if(calls>0) std::cout << Form(" (%.1f kB/call)",bytes/1024.0/calls);
+  std::cout << std::endl;
+  for(uint i=0; i!=fSlots.size(); ++i) {
+    Slot *slot = fSlots[i];
+    if(!slot->fTree || !slot->fTree->GetCurrentFile()) continue;
+    TTree *tree = slot->fTree->GetTree();
+    Long64_t zip = 0;
+    TObjArray *brs = tree->GetListOfBranches();
+    for(int ib=0; ib!=brs->GetEntries(); ++ib) {
+      TBranch *br = (TBranch*) brs->At(ib);
+      if(tree->GetBranchStatus(br->GetName())) zip += br->GetZipBytes("*");
+    }
+    std::cout << "  Slot " << i;
+    if(tree->GetEntries()>0)
+      std::cout << Form(" | active branches %.0f B/entry (compressed)",zip*1.0/tree->GetEntries());
+    TTreeCache *cache = (TTreeCache*) slot->fTree->GetCurrentFile()->GetCacheRead(tree);
+    if(cache) {
+      std::cout << " | cache " << cache->GetBufferSize()/1024 << " kB";
+      std::cout << Form(" hit rate %.3f (rel %.3f)",cache->GetEfficiency(),cache->GetEfficiencyRel());
+    } else {
+      std::cout << " | no read cache";
+    }
+    std::cout << std::endl;
   }
 }
 //=====
 void Analysis::Finish() {
   std::cout << "** Analysis::Finish() **" << std::endl;
-  TFile *fOutputFile = new TFile(fOutputFileName.Data(),"RECREATE");
-  fOutputFile->cd();
-  //---
-  int ntsk = fListOfTasks->GetEntries();
+  ReportIO();
+  bool resumed = false;
+  for(uint i=0; i!=fSlots.size(); ++i)
+    if(fSlots[i]->fCheckpointBase.Length()>0) resumed = true;
+  if(fSlots.size()==1 && !resumed) {
+    TFile *fOutputFile = new TFile(fOutputFileName.Data(),"RECREATE");
+    fOutputFile->cd();
+    FinishSlot( fSlots[0] );
+    fOutputFile->Close();
+    delete fOutputFile;
+  } else {
+    // every slot writes into memory, then the slots are added up
+    // in slot order, the same way hadd would do with one file per range;
+    // a resumed slot brings in what it had done before the restart first
+    TFileMerger merger(kFALSE);
+    merger.OutputFile(fOutputFileName.Data(),"RECREATE");
+    for(uint i=0; i!=fSlots.size(); ++i) {
+      if(fSlots[i]->fCheckpointBase.Length()>0)
+	merger.AddFile(fSlots[i]->fCheckpointBase.Data(),kFALSE);
+      TMemFile *mem = new TMemFile(Form("slot%d.root",i),"RECREATE");
+      mem->cd();
+      FinishSlot( fSlots[i] );
+      mem->Write();
+      merger.AddAdoptFile(mem);
+    }
+    merger.AddObjectNames("_state _progress");
+    merger.PartialMerge(TFileMerger::kAll|TFileMerger::kRegular|TFileMerger::kSkipListed);
+  }
+  std::cout << "Results saved into " << fOutputFileName.Data() << std::endl;
+  if(fCheckpointEvery>0) {
+    // the job is complete, nothing left to resume
+    for(uint i=0; i!=fSlots.size(); ++i) {
+      TString name = CheckpointName(fSlots[i]);
+      gSystem->Unlink(name.Data());
+      gSystem->Unlink(Form("%s.base",name.Data()));
+    }
+  }
+  ReportTiming();
+}
+//=====
+void Analysis::FinishSlot(Slot *slot) {
+  int ntsk = slot->fListOfTasks->GetEntries();
+  double wall, cpu;
+  Lap(NULL,wall,cpu);
+  TDirectory *top = gDirectory;
   for(int i=0; i!=ntsk; ++i) {
-    AnalysisTask *tsk = (AnalysisTask*) fListOfTasks->At(i);
+    AnalysisTask *tsk = (AnalysisTask*) slot->fListOfTasks->At(i);
+    TString dir = tsk->GetOutputDirectory();
+    if(dir.Length()>0) {
+      // several tasks of a train may book histograms with the same names
+      if(!top->GetDirectory(dir.Data())) top->mkdir(dir.Data());
+      top->cd(dir.Data());
+    }
     tsk->Finish();
+    top->cd();
+    Lap(&slot->fTaskTime[i*kNStages+kFinish],wall,cpu);
   }
   //  hEvents->Write();
-  fOutputFile->Close();
-  delete fOutputFile;
-  std::cout << "Results saved into " << fOutputFileName.Data() << std::endl;
-  fInputFile->Close();
+  WriteTiming(slot);
 }
 //=====
 void Analysis::Exec() {
   std::cout << "** Analysis::Exec() **" << std::endl;
-  if(!fTree) return;
-  Long64_t EndOfLoop = fTree->GetEntries();
+  if(!fSlots[0]->fTree) return;
+  Long64_t EndOfLoop = fSlots[0]->fTree->GetEntries();
   if(fNoEventsAnalyzed>0) {
     Long64_t sum = fNoSkipEventsAtBeginning + fNoEventsAnalyzed;
     if(sum<EndOfLoop) EndOfLoop = sum;
   }
   if(fNoSkipEventsAtBeginning<0) fNoSkipEventsAtBeginning=0;
-  for(Long64_t i1=fNoSkipEventsAtBeginning;
+  //---
+  // contiguous ranges, one per slot, so each thread reads its own baskets
+  Long64_t nslots = fSlots.size();
+  Long64_t chunk = (EndOfLoop - fNoSkipEventsAtBeginning)/nslots;
+  for(Long64_t i=0; i!=nslots; ++i) {
+    fSlots[i]->fFirstEntry = fNoSkipEventsAtBeginning + i*chunk;
+    fSlots[i]->fLastEntry = fSlots[i]->fFirstEntry + chunk;
+  }
+  fSlots[nslots-1]->fLastEntry = EndOfLoop;
+  for(Long64_t i=0; i!=nslots; ++i)
+    fSlots[i]->fRangeFirst = fSlots[i]->fFirstEntry;
+  if(fCheckpointEvery>0)
+    for(Long64_t i=0; i!=nslots; ++i)
+      Resume( fSlots[i] );
+  if(fCacheSize>0)
+    for(Long64_t i=0; i!=nslots; ++i)
+      fSlots[i]->fTree->SetCacheEntryRange(fSlots[i]->fFirstEntry,fSlots[i]->fLastEntry);
+  double wall, cpu;
+  Lap(NULL,wall,cpu);
+  fExecWall = -wall;
+  if(nslots==1) {
+    Loop( fSlots[0] );
+  } else {
+    std::vector<std::thread> threads;
+    for(uint i=0; i!=fSlots.size(); ++i)
+      threads.push_back( std::thread(&Analysis::Loop,this,fSlots[i]) );
+    for(uint i=0; i!=threads.size(); ++i)
+      threads[i].join();
+  }
+  Lap(NULL,wall,cpu);
+  fExecWall += wall;
+}
+//=====
+void Analysis::Loop(Slot *slot) {
+  bool verbose = (slot==fSlots[0]);
+  Long64_t EndOfLoop = slot->fLastEntry;
+  // a resumed slot got its carried-over state from the checkpoint
+  if(slot->fFirstEntry>fNoSkipEventsAtBeginning && slot->fCheckpointBase.Length()==0)
+    History(slot);
+  // one clock reading per boundary: each lap is charged to what just ran
+  double wall, cpu, wall0, cpu0;
+  Lap(NULL,wall0,cpu0);
+  wall = wall0;
+  cpu = cpu0;
+  for(Long64_t i1=slot->fFirstEntry;
       i1<EndOfLoop; ++i1) {
-    if(i1%50000 == 0) {
+    if(verbose && i1%50000 == 0) {
       std::cout << " Executing event number :  " << i1 << "/" << EndOfLoop;
       std::cout << Form(" (%.1f)",i1*100.0/EndOfLoop) << std::endl;
     }
     //std::cout << " LOADTREE " << fTree->LoadTree(i1) << std::endl;
     //std::cout << " SIZE " << fTree->GetEntry(i1) << std::endl;
-    fTree->GetEntry(i1);
+    slot->fTree->GetEntry(i1);
+    slot->fEvent->Unpack();
+    slot->fTracks->NewEvent();
+    // candidates and event planes belong to this event: a producer that
+    // rejects it must not leave the previous one to its consumers
+    slot->fCandidates->Clear();
+    slot->fCandidates2->Clear();
+    for(int k=0; k!=4; ++k)
+      slot->fQ[k]->SetXY(0,0,0,0);
+    if(fTiming) Lap(&slot->fIOTime,wall,cpu);
+    if(fInputFiles.size()>1 &&
+       slot->fTree->GetTreeNumber()!=slot->fTreeNumber) {
+      NewFile(slot);
+      if(fTiming) Lap(NULL,wall,cpu);
+    }
     //---
-    int ntsk = fListOfTasks->GetEntries();
+    int ntsk = slot->fListOfTasks->GetEntries();
     for(int i=0; i!=ntsk; ++i) {
-      AnalysisTask *tsk = (AnalysisTask*) fListOfTasks->At(i);
+      AnalysisTask *tsk = (AnalysisTask*) slot->fListOfTasks->At(i);
       tsk->Exec();
+      if(fTiming) Lap(&slot->fTaskTime[i*kNStages+kExec],wall,cpu);
     }
     //---
+    if(fCheckpointEvery>0 && i1+1<EndOfLoop &&
+       (i1+1-slot->fRangeFirst)%fCheckpointEvery==0) {
+      WriteCheckpoint(slot,i1+1);
+      if(fTiming) Lap(NULL,wall,cpu);
+    }
+  }
+  Lap(&slot->fLoopTime,wall0,cpu0);
+  slot->fLoopTime.fCalls = EndOfLoop - slot->fFirstEntry;
+}
+//=====
+void Analysis::History(Slot *slot) {
+  // state a task carries from event to event (mixing pools) would, in a
+  // serial run, come from the events before this range: they are shown
+  // to the tasks newest first until none of them needs older ones
+  int ntsk = slot->fListOfTasks->GetEntries();
+  std::vector<bool> more(ntsk,true);
+  int nmore = ntsk;
+  Long64_t i1 = slot->fFirstEntry;
+  while(nmore>0 && i1>fNoSkipEventsAtBeginning) {
+    --i1;
+    slot->fTree->GetEntry(i1);
+    slot->fEvent->Unpack();
+    slot->fTracks->NewEvent();
+    slot->fCandidates->Clear();
+    slot->fCandidates2->Clear();
+    for(int k=0; k!=4; ++k)
+      slot->fQ[k]->SetXY(0,0,0,0);
+    if(fInputFiles.size()>1 &&
+       slot->fTree->GetTreeNumber()!=slot->fTreeNumber)
+      NewFile(slot);
+    for(int i=0; i!=ntsk; ++i) {
+      if(!more[i]) continue;
+      AnalysisTask *tsk = (AnalysisTask*) slot->fListOfTasks->At(i);
+      if(tsk->History()) continue;
+      more[i] = false;
+      --nmore;
+    }
+  }
+  for(int i=0; i!=ntsk; ++i)
+    ((AnalysisTask*) slot->fListOfTasks->At(i))->EndHistory();
+  if(slot->fFirstEntry-i1>1)
+    std::cout << " Entries " << i1 << "-" << slot->fFirstEntry << " read back for the state at "
+	      << slot->fFirstEntry << std::endl;
+}
+//=====
+void Analysis::NewFile(Slot *slot) {
+  slot->fTreeNumber = slot->fTree->GetTreeNumber();
+  TString tag = TagOfFile( slot->fTree->GetCurrentFile()->GetName() );
+  TObjArray *arr = tag.Tokenize("_");
+  int run = ((TObjString*) arr->At(0))->GetString().Atoi();
+  delete arr;
+  if(run==slot->fRun) return;
+  // per-run state (calibration tables) follows the file being read
+  if(slot==fSlots[0])
+    std::cout << " Switching to run " << run << " (" << tag.Data() << ")" << std::endl;
+  slot->fRun = run;
+  int ntsk = slot->fListOfTasks->GetEntries();
+  double wall, cpu;
+  Lap(NULL,wall,cpu);
+  for(int i=0; i!=ntsk; ++i) {
+    AnalysisTask *tsk = (AnalysisTask*) slot->fListOfTasks->At(i);
+    tsk->InitRun(run);
+    Lap(&slot->fTaskTime[i*kNStages+kInitRun],wall,cpu);
+  }
+}
+//=====
+TString Analysis::CheckpointName(Slot *slot) {
+  int islot = 0;
+  for(uint i=0; i!=fSlots.size(); ++i) if(fSlots[i]==slot) islot = i;
+  if(islot==0) return fCheckpointFile;
+  TString name = fCheckpointFile;
+  if(name.EndsWith(".root")) name.Remove(name.Length()-5);
+  name += Form("_slot%d",islot);
+  if(fCheckpointFile.EndsWith(".root")) name += ".root";
+  return name;
+}
+//=====
+void Analysis::WriteCheckpoint(Slot *slot, Long64_t next) {
+  // results (what Finish would write now, added to those from before a
+  // restart), progress and task state go to a temporary file that then
+  // replaces the previous checkpoint in one rename
+  TString name = CheckpointName(slot);
+  TString tmp = name + ".tmp";
+  TDirectory::TContext ctx;
+  TMemFile *mem = new TMemFile(Form("%s.mem",name.Data()),"RECREATE");
+  mem->cd();
+  FinishSlot( slot );
+  mem->Write();
+  TFileMerger merger(kFALSE,kFALSE);
+  merger.SetPrintLevel(0);
+  merger.OutputFile(tmp.Data(),"RECREATE");
+  if(slot->fCheckpointBase.Length()>0)
+    merger.AddFile(slot->fCheckpointBase.Data(),kFALSE);
+  merger.AddAdoptFile(mem);
+  merger.AddObjectNames("_state _progress");
+  if(!merger.PartialMerge(TFileMerger::kAll|TFileMerger::kRegular|TFileMerger::kSkipListed)) {
+    std::cout << " Checkpoint " << name.Data() << " could not be written." << std::endl;
+    return;
+  }
+  TFile *fout = new TFile(tmp.Data(),"UPDATE");
+  TTree *progress = new TTree("_progress","checkpoint progress");
+  Long64_t first = slot->fRangeFirst;
+  Long64_t last = slot->fLastEntry;
+  progress->Branch("first",&first,"first/L");
+  progress->Branch("last",&last,"last/L");
+  progress->Branch("next",&next,"next/L");
+  progress->Fill();
+  progress->Write();
+  delete progress;
+  TDirectory *state = fout->mkdir("_state");
+  int ntsk = slot->fListOfTasks->GetEntries();
+  for(int i=0; i!=ntsk; ++i) {
+    AnalysisTask *tsk = (AnalysisTask*) slot->fListOfTasks->At(i);
+    TDirectory *dir = state->mkdir(Form("task%d",i));
+    dir->cd();
+    tsk->SaveState(dir);
+  }
+  fout->Close();
+  delete fout;
+  std::rename(tmp.Data(),name.Data());
+  if(slot==fSlots[0])
+    std::cout << " Checkpoint at entry " << next << " in " << name.Data() << std::endl;
+}
+//=====
+void Analysis::Resume(Slot *slot) {
+  TString name = CheckpointName(slot);
+  if(gSystem->AccessPathName(name.Data())) return; // nothing to resume
+  TFile *fin = TFile::Open(name.Data(),"READ");
+  TTree *progress = fin ? (TTree*) fin->Get("_progress") : NULL;
+  if(!progress) {
+    std::cout << " Checkpoint " << name.Data() << " unreadable, starting over." << std::endl;
+    if(fin) delete fin;
+    return;
+  }
+  Long64_t first, last, next;
+  progress->SetBranchAddress("first",&first);
+  progress->SetBranchAddress("last",&last);
+  progress->SetBranchAddress("next",&next);
+  progress->GetEntry(0);
+  if(first!=slot->fRangeFirst || last!=slot->fLastEntry) {
+    std::cout << " Checkpoint " << name.Data() << " is for entries " << first << "-" << last;
+    std::cout << ", not " << slot->fRangeFirst << "-" << slot->fLastEntry << ". Starting over." << std::endl;
+    delete fin;
+    return;
+  }
+  int ntsk = slot->fListOfTasks->GetEntries();
+  for(int i=0; i!=ntsk; ++i) {
+    AnalysisTask *tsk = (AnalysisTask*) slot->fListOfTasks->At(i);
+    TDirectory *dir = fin->GetDirectory(Form("_state/task%d",i));
+    if(dir) tsk->LoadState(dir);
+  }
+  delete fin;
+  // the results so far are added back at the next checkpoint and at Finish
+  slot->fCheckpointBase = name + ".base";
+  std::rename(name.Data(),slot->fCheckpointBase.Data());
+  slot->fFirstEntry = next;
+  std::cout << " Resuming entries " << first << "-" << last << " at " << next;
+  std::cout << " from " << name.Data() << std::endl;
+}
+//=====
+void Analysis::Lap(Timer *tm, double &wall, double &cpu) {
+  // thread cpu clock, so that slots running in parallel are not mixed up
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  double nwall = ts.tv_sec + 1e-9*ts.tv_nsec;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID,&ts);
+  double ncpu = ts.tv_sec + 1e-9*ts.tv_nsec;
+  if(tm) {
+    tm->fWall += nwall - wall;
+    tm->fCpu += ncpu - cpu;
+    tm->fCalls++;
+  }
+  wall = nwall;
+  cpu = ncpu;
+}
+//=====
+TString Analysis::TaskName(TObject *obj) {
+  // tasks carry no dictionary, ask the compiler instead
+  const char *mangled = typeid(*obj).name();
+  int status = 0;
+  char *name = abi::__cxa_demangle(mangled,NULL,NULL,&status);
+  TString ret = (status==0&&name) ? name : mangled;
+  free(name);
+  return ret;
+}
+//=====
+void Analysis::WriteTiming(Slot *slot) {
+  // one entry per task and slot; slot files are merged by concatenation
+  static const char *stage[kNStages] = {"Init","InitRun","Exec","Finish"};
+  int islot = 0;
+  for(uint i=0; i!=fSlots.size(); ++i) if(fSlots[i]==slot) islot = i;
+  TTree *tree = new TTree("Timing","task timing (s)");
+  Int_t bslot = islot;
+  char btask[128];
+  Long64_t bcalls[kNStages];
+  Double_t bwall[kNStages], bcpu[kNStages];
+  tree->Branch("slot",&bslot,"slot/I");
+  tree->Branch("task",btask,"task/C");
+  for(int j=0; j!=kNStages; ++j) {
+    tree->Branch(Form("%sCalls",stage[j]),&bcalls[j],Form("%sCalls/L",stage[j]));
+    tree->Branch(Form("%sWall",stage[j]),&bwall[j],Form("%sWall/D",stage[j]));
+    tree->Branch(Form("%sCpu",stage[j]),&bcpu[j],Form("%sCpu/D",stage[j]));
+  }
+  int ntsk = slot->fListOfTasks->GetEntries();
+  for(int i=0; i!=ntsk+2; ++i) {
+    for(int j=0; j!=kNStages; ++j) {
+      Timer tm;
+      if(i<ntsk) tm = slot->fTaskTime[i*kNStages+j];
+      else if(j==kExec) tm = (i==ntsk) ? slot->fIOTime : slot->fLoopTime;
+      bcalls[j] = tm.fCalls;
+      bwall[j] = tm.fWall;
+      bcpu[j] = tm.fCpu;
+    }
+    TString name = "GetEntry";
+    if(i<ntsk) name = TaskName( slot->fListOfTasks->At(i) );
+    else if(i>ntsk) name = "Loop";
+    snprintf(btask,sizeof(btask),"%s",name.Data());
+    tree->Fill();
   }
+  tree->Write();
+  delete tree;
+}
+//=====
+void Analysis::ReportTiming() {
+  // stdout summary plus a tab separated copy next to the output file
+  static const char *stage[kNStages] = {"Init","InitRun","Exec","Finish"};
+  TString tsv = fOutputFileName;
+  if(tsv.EndsWith(".root")) tsv.Remove(tsv.Length()-5);
+  tsv += ".timing.tsv";
+  std::ofstream fout( tsv.Data() );
+  fout << "slot\ttask\tstage\tcalls\twall\tcpu" << std::endl;
+  Long64_t nev = 0;
+  std::vector<Timer> sum;
+  Timer io;
+  for(uint is=0; is!=fSlots.size(); ++is) {
+    Slot *slot = fSlots[is];
+    int ntsk = slot->fListOfTasks->GetEntries();
+    if(sum.size()==0) sum.resize(ntsk);
+    for(int i=0; i!=ntsk; ++i) {
+      TString name = TaskName( slot->fListOfTasks->At(i) );
+      for(int j=0; j!=kNStages; ++j) {
+	Timer &tm = slot->fTaskTime[i*kNStages+j];
+	fout << is << "\t" << name.Data() << "\t" << stage[j] << "\t" << tm.fCalls;
+	fout << "\t" << tm.fWall << "\t" << tm.fCpu << std::endl;
+      }
+      sum[i].fWall += slot->fTaskTime[i*kNStages+kExec].fWall;
+      sum[i].fCpu += slot->fTaskTime[i*kNStages+kExec].fCpu;
+    }
+    fout << is << "\tGetEntry\tExec\t" << slot->fIOTime.fCalls;
+    fout << "\t" << slot->fIOTime.fWall << "\t" << slot->fIOTime.fCpu << std::endl;
+    fout << is << "\tLoop\tExec\t" << slot->fLoopTime.fCalls;
+    fout << "\t" << slot->fLoopTime.fWall << "\t" << slot->fLoopTime.fCpu << std::endl;
+    io.fWall += slot->fIOTime.fWall;
+    io.fCpu += slot->fIOTime.fCpu;
+    nev += slot->fLoopTime.fCalls;
+  }
+  fout << "-1\tTotal\tExec\t" << nev << "\t" << fExecWall << "\t0" << std::endl;
+  fout.close();
+  //---
+  std::cout << " ** Timing summary (Exec, summed over threads) **" << std::endl;
+  std::cout << Form("  %-20s %10s %10s","","wall (s)","cpu (s)") << std::endl;
+  std::cout << Form("  %-20s %10.2f %10.2f","GetEntry",io.fWall,io.fCpu) << std::endl;
+  for(uint i=0; i!=sum.size(); ++i)
+    std::cout << Form("  %-20s %10.2f %10.2f",TaskName(fListOfTasks->At(i)).Data(),
+		      sum[i].fWall,sum[i].fCpu) << std::endl;
+  if(fExecWall>0)
+    std::cout << Form("  %lld events in %.1f s: %.0f events/s",nev,fExecWall,nev/fExecWall) << std::endl;
+  std::cout << " Timing written to " << tsv.Data() << std::endl;
+}
+//=====
+void Analysis::InputFileList(TString list, TString pattern) {
+  // one segment (RUN_SEGMENT) or one root file per line
+  std::ifstream fin( list.Data() );
+  std::string line;
+  while(fin >> line) {
+    TString name = line.c_str();
+    if(!name.EndsWith(".root")) name = Form(pattern.Data(),name.Data());
+    AddInputFile( name );
+  }
+  fin.close();
+  std::cout << " " << fInputFiles.size() << " files listed in " << list.Data() << std::endl;
+}
+//=====
+TString Analysis::TagOfFile(TString name) {
+  // trees/454774_0.root ==> 454774_0
+  TString tag = name;
+  int slash = tag.Last('/');
+  if(slash>=0) tag.Remove(0,slash+1);
+  if(tag.EndsWith(".root")) tag.Remove(tag.Length()-5);
+  return tag;
+}
+//=====
+int Analysis::SlotNumber() {
+  for(uint i=0; i!=fSlots.size(); ++i)
+    if(fSlots[i]==fSlot) return i;
+  return 0;
 }
 //=====
 int Analysis::RunNumber() {
@@ -6,10 +6,12 @@
 #include <TList.h>
 #include <TH2F.h>
 #include <TLorentzVector.h>
+#include <TChain.h>
 #include "qcQ.h"
 #include "AnalysisTask.h"
+#include "EventBuffers.h"
+#include "TrackSelection.h"
 
-class TFile;
 class TTree;
 
 class Analysis {
@@ -25,34 +27,112 @@ class Analysis {
   void Finish();
   void AddTask(AnalysisTask *tsk) {fListOfTasks->Add(tsk);}
   void InputFileName(TString name) {fInputFileName = name;}
+  void AddInputFile(TString name) {fInputFiles.push_back(name);}
+  void InputFileList(TString list, TString pattern="trees/%s.root");
   void OutputFileName(TString name) {fOutputFileName = name;}
   void DataSetTag(TString name) {fDSTag =name;}
   void NumberOfEventsToSkipAtBeginning(Long64_t skp) {fNoSkipEventsAtBeginning = skp;}
   void NumberOfEventsToAnalyze(Long64_t nev) {fNoEventsAnalyzed = nev;}
-  TTree* GetTree() {return fTree;}
+  // each thread runs a contiguous range of entries; state carried across
+  // events is rebuilt from the entries before the range (see
+  // AnalysisTask::History). The merge adds the ranges up, so weighted
+  // sums can differ from a serial run in the last bits
+  void NumberOfThreads(int nth) {fNThreads = nth;}
+  void ReadCacheSize(Long64_t bytes) {fCacheSize = bytes;}
+  // input files hold QCACHE trees (see AT_QCache) instead of TOP
+  void QCacheInput(bool val=true) {fQCache = val;}
+  void ParallelUnzip(bool val=true) {fParallelUnzip = val;}
+  void Timing(bool val=true) {fTiming = val;}
+  // every <every> entries each thread saves its results and the entry it
+  // got to in <file> (<file>_slotN for extra threads); a job restarted
+  // with the same settings carries on from there
+  void Checkpoint(TString file, Long64_t every=100000)
+  {fCheckpointFile = file; fCheckpointEvery = every;}
+  TTree* GetTree() {return fSlot->fTree;}
+  EventBuffers* GetEvent() {return fSlot->fEvent;}
   TString GetInputFileName() {return fInputFileName;} // used for calibration purposes
-  std::vector<TLorentzVector>* GetCandidates() {return fCandidates;}
-  std::vector<TLorentzVector>* GetCandidates2() {return fCandidates2;}
-  qcQ* GetQ(int n) {return fQ[n];}
+  TString GetDataSetTag() {return fDSTag;}
+  Candidates* GetCandidates() {return fSlot->fCandidates;}
+  Candidates* GetCandidates2() {return fSlot->fCandidates2;}
+  // names of the cut sets behind Candidates::Cuts bits (0 is nominal)
+  std::vector<TString>* GetCandidateCutNames() {return &fSlot->fCutNames;}
+  qcQ* GetQ(int n) {return fSlot->fQ[n];}
+  TrackSelection* GetTrackSelection() {return fSlot->fTracks;}
+  int SlotNumber(); // of the slot being initialised, 0 is the main thread
   int RunNumber();
   int SegmentNumber();
+  static TString TagOfFile(TString name);
 
  protected:
   Analysis();
-  
+
  private:
+  // accumulated wall and cpu (of the calling thread) time, in seconds
+  struct Timer {
+    Timer() : fWall(0), fCpu(0), fCalls(0) {}
+    double fWall;
+    double fCpu;
+    Long64_t fCalls;
+  };
+  enum {kInit, kInitRun, kExec, kFinish, kNStages};
+  // Everything an event loop needs for itself. Slot 0 holds the tasks
+  // added by the user, the other slots hold their clones (one per thread).
+  struct Slot {
+    Slot();
+    ~Slot();
+    TList *fListOfTasks;
+    TChain *fTree;
+    EventBuffers *fEvent;
+    TrackSelection *fTracks;
+    std::vector<TString> fBranches;
+    int fTreeNumber;
+    int fRun;
+    Candidates *fCandidates;
+    Candidates *fCandidates2;
+    std::vector<TString> fCutNames;
+    qcQ *fQ[4];
+    Long64_t fFirstEntry;
+    Long64_t fLastEntry;
+    Long64_t fRangeFirst; // range as assigned, fFirstEntry moves on resume
+    TString fCheckpointBase; // results before the restart
+    std::vector<Timer> fTaskTime; // [task*kNStages+stage]
+    Timer fIOTime;
+    Timer fLoopTime;
+  };
+  void InitSlot(Slot*);
+  void SelectBranches(Slot*);
+  void SetupCache(Slot*);
+  void ReportIO();
+  void ReportTiming();
+  void WriteTiming(Slot*);
+  void Lap(Timer *tm, double &wall, double &cpu);
+  static TString TaskName(TObject*);
+  void FinishSlot(Slot*);
+  void Loop(Slot*);
+  void History(Slot*);
+  void NewFile(Slot*);
+  TString CheckpointName(Slot*);
+  void WriteCheckpoint(Slot*, Long64_t next);
+  void Resume(Slot*);
+
   static Analysis *fAnalysis;
   TString fInputFileName;
+  std::vector<TString> fInputFiles;
   TString fOutputFileName;
   TString fDSTag;
   Long64_t fNoSkipEventsAtBeginning;
   Long64_t fNoEventsAnalyzed;
+  int fNThreads;
+  Long64_t fCacheSize;
+  bool fQCache;
+  bool fParallelUnzip;
+  bool fTiming;
+  TString fCheckpointFile;
+  Long64_t fCheckpointEvery;
+  double fExecWall;
   TList *fListOfTasks;
-  TFile *fInputFile;
-  TTree *fTree;
-  std::vector<TLorentzVector> *fCandidates;
-  std::vector<TLorentzVector> *fCandidates2;
-  qcQ *fQ[4];
+  std::vector<Slot*> fSlots;
+  Slot *fSlot; // slot being initialised, seen by tasks through the getters
 };
 
 #endif
@@ -5,8 +5,10 @@
 #include <vector>
 #include <TObject.h>
 #include <TString.h>
-#include <TLorentzVector.h>
 #include "qcQ.h"
+#include "Candidates.h"
+
+class TDirectory;
 
 class AnalysisTask : public TObject { // needed to add to TLists
  public:
@@ -19,11 +21,34 @@ class AnalysisTask : public TObject { // needed to add to TLists
   virtual void Init() {std::cout << "AT::INIT" << std::endl;}
   virtual void Exec() {std::cout << "AT::EXEC" << std::endl;}
   virtual void Finish() {std::cout << "AT::FINISH" << std::endl;}
+  // called by Analysis when a chained input moves on to another run
+  virtual void InitRun(int) {}
+  // names (wildcards allowed) of the TOP branches the task reads;
+  // branches nobody asks for are switched off and never allocated
+  virtual void Branches(std::vector<TString>&) {}
+  // fresh copy of a configured (not yet initialised) task for another
+  // event-loop thread; tasks returning NULL force a single-threaded run
+  virtual AnalysisTask* CloneTask() const {return NULL;}
+  // checkpoints call Finish() in the middle of the run, tasks for which
+  // that is not harmless say so here; state that is not written out by
+  // Finish (e.g. mixing pools) goes through Save/LoadState
+  virtual bool CanCheckpoint() const {return true;}
+  virtual void SaveState(TDirectory*) {}
+  virtual void LoadState(TDirectory*) {}
+  // events before the range of a thread, newest first, so that state
+  // carried across events starts as in a serial run; true while older
+  // events are still wanted. EndHistory closes the scan
+  virtual bool History() {return false;}
+  virtual void EndHistory() {}
+  // directory of the output file the task writes into (default: top)
+  void OutputDirectory(TString dir) {fOutputDir=dir;}
+  TString GetOutputDirectory() const {return fOutputDir;}
 
  protected:
-  std::vector<TLorentzVector> *fCandidates;
-  std::vector<TLorentzVector> *fCandidates2;
+  Candidates *fCandidates;  // same event
+  Candidates *fCandidates2; // mixed events
   qcQ *fQ[4];
+  TString fOutputDir;
 };
 
 #endif
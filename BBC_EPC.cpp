@@ -1,7 +1,11 @@
 #include "Analysis.h"
 #include "AT_ReadTree.h"
 #include "AT_BBC_EPC.h"
+#include "AT_BBC_Calib.h"
 
+// Run_BBC_EPC <segment> <nev>          calibration histograms of a segment
+// Run_BBC_EPC <segments.dat> <nev> CALIB
+//   all tables of the runs in the list, in one pass (AT_BBC_Calib)
 int main(int argc, char *argv[]){
   if(argc<3) {
     return 1;
@@ -9,16 +13,29 @@ int main(int argc, char *argv[]){
   TString run = argv[1];
   TString snev = argv[2];
   int nev = snev.Atoi();
+  bool calib = (argc>3 && TString(argv[3])=="CALIB");
 
   Analysis *ana = Analysis::Instance();
-  ana->InputFileName( Form("trees/%s.root",run.Data()) );
+  if(run.EndsWith(".dat")) {
+    ana->InputFileList( run );
+    run = Analysis::TagOfFile( run );
+    run.ReplaceAll(".dat","");
+  } else {
+    ana->InputFileName( Form("trees/%s.root",run.Data()) );
+    ana->DataSetTag( run );
+  }
   ana->OutputFileName( Form("BBC_EPC/out/out_%s.root",run.Data()) );
-  ana->DataSetTag( run );
   ana->NumberOfEventsToAnalyze( nev );
 
-  AT_BBC_EPC *tsk = new AT_BBC_EPC();
-  tsk->SkipBBCQCal();
-  ana->AddTask( tsk );
+  if(calib) {
+    AT_BBC_Calib *tsk = new AT_BBC_Calib();
+    tsk->SkipBBCQCal();
+    ana->AddTask( tsk );
+  } else {
+    AT_BBC_EPC *tsk = new AT_BBC_EPC();
+    tsk->SkipBBCQCal();
+    ana->AddTask( tsk );
+  }
 
   ana->Run();
 
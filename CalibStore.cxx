@@ -0,0 +1,241 @@
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "CalibStore.h"
+
+namespace {
+  struct Header {
+    char magic[8];
+    int version;
+    int ncells;
+    int ncell;
+    int nres;
+    int runmin;
+    int runmax;
+    int nruns;
+    int pad[7];
+  };
+  const char kMagic[8] = "TACALIB";
+  long DataOffset(int nspan, int nruns) {
+    long off = sizeof(Header) + sizeof(int)*(long)(nspan+nruns);
+    return (off+63)/64*64;
+  }
+  std::mutex gOpenMutex;
+  std::map<TString,CalibStore*> gStores;
+  std::map<TString,EPCalib*> gCalibs;
+  MXCell gMXZero[CalibStore::kNCells];
+  // newest modification time of the text tables of <run>, 0 if none
+  long TablesTime(TString dir, int run) {
+    const char *names[3] = {"BBC_%d.dat","BBC_A_%d.dat","BBC_R_%d.dat"};
+    long newest = 0;
+    struct stat st;
+    for(int i=0; i!=3; ++i) {
+      TString name = dir + "/" + Form(names[i],run);
+      if(stat(name.Data(),&st)==0 && st.st_mtime>newest) newest = st.st_mtime;
+    }
+    return newest;
+  }
+}
+
+CalibStore::CalibStore() {
+  fMap = NULL;
+  fSize = 0;
+  fRunMin = 0;
+  fRunMax = -1;
+  fIndex = NULL;
+  fParts = NULL;
+  fData = NULL;
+  fTime = 0;
+}
+
+CalibStore::~CalibStore() {
+  if(fMap) munmap(fMap,fSize);
+}
+
+const EPCalib* CalibStore::Get(TString file, TString tables, int run) {
+  CalibStore *store = Open(file);
+  std::lock_guard<std::mutex> lock(gOpenMutex);
+  TString key = Form("%s|%s|%d",file.Data(),tables.Data(),run);
+  std::map<TString,EPCalib*>::iterator it = gCalibs.find(key);
+  if(it!=gCalibs.end()) return it->second;
+  EPCalib *cal = new EPCalib();
+  const float *rec = store ? store->Record(run) : NULL;
+  if(rec && TablesTime(tables,run)>store->fTime) {
+    // recalibrated after the store was made: the store is stale here
+    std::cout << "CalibStore::Get === run " << run << " has tables in " << tables.Data()
+	      << " newer than " << file.Data() << ", using the tables" << std::endl;
+    rec = NULL;
+  }
+  if(rec && (store->Parts(run)&(kRecenter|kFlat))) {
+    cal->fParts = store->Parts(run);
+    std::cout << "CalibStore::Get === run " << run << " mapped from " << file.Data() << std::endl;
+  } else {
+    // not in the store: parse the text tables, once per process
+    float *own = NULL;
+    if(posix_memalign((void**) &own,64,sizeof(float)*kNRecord)!=0) own = new float[kNRecord];
+    std::fill(own,own+kNRecord,0.0f);
+    cal->fParts = ReadTables(run,tables,own);
+    rec = own;
+    std::cout << "CalibStore::Get === run " << run << " loaded from " << tables.Data() << std::endl;
+  }
+  cal->fCells = (const EPCell*) rec;
+  cal->fMX = gMXZero;
+  cal->fRes = rec + kNCells*kNCell;
+  cal->fRun = run;
+  gCalibs[key] = cal;
+  return cal;
+}
+
+CalibStore* CalibStore::Open(TString file) {
+  // InitRun of every slot comes here, possibly at the same time
+  std::lock_guard<std::mutex> lock(gOpenMutex);
+  std::map<TString,CalibStore*>::iterator it = gStores.find(file);
+  if(it!=gStores.end()) return it->second;
+  CalibStore *store = new CalibStore();
+  if(!store->Map(file)) {
+    delete store;
+    store = NULL;
+  }
+  gStores[file] = store; // failures too, not to retry for every run
+  return store;
+}
+
+bool CalibStore::Map(TString file) {
+  int fd = open(file.Data(),O_RDONLY);
+  if(fd<0) return false;
+  struct stat st;
+  if(fstat(fd,&st)!=0 || st.st_size<(long)sizeof(Header)) {
+    close(fd);
+    return false;
+  }
+  fSize = st.st_size;
+  fTime = st.st_mtime;
+  fMap = mmap(NULL,fSize,PROT_READ,MAP_SHARED,fd,0);
+  close(fd);
+  if(fMap==MAP_FAILED) {
+    fMap = NULL;
+    return false;
+  }
+  const Header *h = (const Header*) fMap;
+  if(memcmp(h->magic,kMagic,8)!=0 || h->version!=kVersion ||
+     h->ncells!=kNCells || h->ncell!=kNCell || h->nres!=kNRes) {
+    std::cout << "CalibStore::Map === " << file.Data() << " is not a version " << kVersion << " store" << std::endl;
+    return false;
+  }
+  int nspan = h->runmax - h->runmin + 1;
+  long off = DataOffset(nspan,h->nruns);
+  if(nspan<0 || fSize < off+(long)sizeof(float)*kNRecord*h->nruns) {
+    std::cout << "CalibStore::Map === " << file.Data() << " is truncated" << std::endl;
+    return false;
+  }
+  fFileName = file;
+  fRunMin = h->runmin;
+  fRunMax = h->runmax;
+  fIndex = (const int*) (h+1);
+  fParts = fIndex + nspan;
+  fData = (const float*) ((const char*) fMap + off);
+  std::cout << "CalibStore::Map === " << h->nruns << " runs mapped from " << file.Data() << std::endl;
+  return true;
+}
+
+bool CalibStore::Create(TString file, const std::vector<int> &runs,
+			int (*fill)(int run, float *record)) {
+  if(runs.size()==0) return false;
+  Header h;
+  memset(&h,0,sizeof(h));
+  memcpy(h.magic,kMagic,8);
+  h.version = kVersion;
+  h.ncells = kNCells;
+  h.ncell = kNCell;
+  h.nres = kNRes;
+  h.runmin = runs[0];
+  h.runmax = runs[0];
+  for(unsigned int i=0; i!=runs.size(); ++i) {
+    if(runs[i]<h.runmin) h.runmin = runs[i];
+    if(runs[i]>h.runmax) h.runmax = runs[i];
+  }
+  h.nruns = runs.size();
+  int nspan = h.runmax - h.runmin + 1;
+  std::vector<int> index(nspan,-1);
+  std::vector<int> parts(h.nruns,0);
+  for(int i=0; i!=h.nruns; ++i)
+    index[runs[i]-h.runmin] = i;
+
+  TString tmp = file + ".tmp";
+  FILE *fout = fopen(tmp.Data(),"wb");
+  if(!fout) return false;
+  long off = DataOffset(nspan,h.nruns);
+  std::vector<char> pad(off,0);
+  fwrite(pad.data(),1,off,fout); // header and index are written last
+  std::vector<float> record(kNRecord);
+  for(int i=0; i!=h.nruns; ++i) {
+    std::fill(record.begin(),record.end(),0.0f);
+    parts[i] = fill(runs[i],record.data());
+    fwrite(record.data(),sizeof(float),kNRecord,fout);
+  }
+  fseek(fout,0,SEEK_SET);
+  fwrite(&h,sizeof(h),1,fout);
+  fwrite(index.data(),sizeof(int),nspan,fout);
+  fwrite(parts.data(),sizeof(int),h.nruns,fout);
+  bool ok = !ferror(fout);
+  ok = (fclose(fout)==0) && ok;
+  if(ok) ok = (rename(tmp.Data(),file.Data())==0);
+  if(!ok) std::cout << "CalibStore::Create === failed writing " << file.Data() << std::endl;
+  return ok;
+}
+
+int CalibStore::ReadTables(int run, TString dir, float *record) {
+  float *res = record + kNCells*kNCell;
+  int parts = 0;
+  std::ifstream fin;
+  float tmp;
+  fin.open( Form("%s/BBC_%d.dat",dir.Data(),run) );
+  int nn=0;
+  for(;nn!=2*6*2*60*40;++nn) {
+    fin >> tmp;
+    if(!fin.good()) break;
+    int ord = (nn/9600)%6;
+    int xy = (nn/4800)%2;
+    int se = (nn/2400)%2;
+    int bce = (nn/40)%60;
+    int bvt = nn%40;
+    Recenter(record,se,ord,xy,bce,bvt) = tmp*1e-1;
+  }
+  fin.close();
+  if(nn>0) parts |= kRecenter;
+  fin.clear();
+  fin.open( Form("%s/BBC_A_%d.dat",dir.Data(),run) );
+  nn=0;
+  for(;nn!=4*60*2*32*40;++nn) {
+    fin >> tmp;
+    if(!fin.good()) break;
+    int ord = (nn/153600)%4;
+    int bce = (nn/2560)%60;
+    int bcs = (nn/1280)%2;
+    int bor = (nn/40)%32;
+    int bvt = nn%40;
+    if(bcs==0) FlatCos(record,bor,ord,bce,bvt) = tmp*1e-3;
+    else FlatSin(record,bor,ord,bce,bvt) = tmp*1e-3;
+  }
+  fin.close();
+  if(nn>0) parts |= kFlat;
+  fin.clear();
+  fin.open( Form("%s/BBC_R_%d.dat",dir.Data(),run) );
+  nn=0;
+  for(;nn!=kNRes;++nn) {
+    fin >> res[nn];
+    if(!fin.good()) break;
+  }
+  fin.close();
+  if(nn>0) parts |= kRes;
+  return parts;
+}
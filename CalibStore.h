@@ -0,0 +1,110 @@
+#ifndef __CALIBSTORE_HH__
+#define __CALIBSTORE_HH__
+
+#include <vector>
+#include <TString.h>
+
+// Coefficients of one (centrality, vertex) cell: everything the BBC
+// event-plane correction of one event reads, in 18 cache lines.
+struct EPCell {
+  float m[2][6][2];  //se ord xy   recentering
+  float c[4][32];    //ord har     flattening <cos>
+  float s[4][32];    //ord har     flattening <sin>
+  float pad[8];      //cells start on a cache line
+};
+
+// Same for the MX sub-events. No MX tables are produced yet, so every
+// run shares one zero table.
+struct MXCell {
+  float m[8][6][2];  //se ord xy
+  float c[4][32];    //ord har
+  float s[4][32];    //ord har
+};
+
+// Calibration of one run, read-only and shared by every task and thread
+// of the process. Get it from CalibStore::Get.
+class EPCalib {
+ public:
+  enum {kNCen=60, kNVtx=40};
+  const EPCell& Cell(int bcen, int bvtx) const {return fCells[bcen*kNVtx+bvtx];}
+  const MXCell& MX(int bcen, int bvtx) const {return fMX[bcen*kNVtx+bvtx];}
+  const float* Resolution() const {return fRes;} //ord bcen [p0 ep0 p1 ep1]
+  int Parts() const {return fParts;}
+  int Run() const {return fRun;}
+
+ private:
+  friend class CalibStore;
+  EPCalib() {}
+  const EPCell *fCells;
+  const MXCell *fMX;
+  const float *fRes;
+  int fParts;
+  int fRun;
+};
+
+// Event-plane calibration of all runs in one binary file, mapped in
+// memory: a run is found through a dense run index and its coefficients
+// are used in place, nothing is parsed or copied.
+//
+// File (version 2), native byte order:
+//  header   magic "TACALIB", version, block sizes, run range, runs
+//  index    int[runmax-runmin+1], record of each run or -1
+//  parts    int[nruns], kRecenter|kFlat|kRes present in each record
+//  records  float[kNRecord] per run, 64-byte aligned:
+//           EPCell[bcen][bvtx]
+//           res [ord][bcen][p0 ep0 p1 ep1]  (BBC_R table)
+// Missing parts are stored as zeros.
+class CalibStore {
+ public:
+  enum {kVersion=2};
+  enum {kNCells=EPCalib::kNCen*EPCalib::kNVtx, kNCell=sizeof(EPCell)/sizeof(float)};
+  enum {kNRes=4*60*4, kNRecord=kNCells*kNCell+kNRes};
+  enum {kRecenter=1, kFlat=2, kRes=4};
+
+  // calibration of <run>: from the store <file> when the run is there
+  // and its text tables in <tables> are not newer than the store, else
+  // from the tables. Built once per run and kept for the whole process;
+  // never NULL (zeros when nothing is found).
+  static const EPCalib* Get(TString file, TString tables, int run);
+  // one mapping per file; NULL if the file is absent or not a valid store
+  static CalibStore* Open(TString file);
+  // writes a store with one record per run; fill(run,record) gets a
+  // zeroed record and returns the parts it filled
+  static bool Create(TString file, const std::vector<int> &runs,
+		     int (*fill)(int run, float *record));
+  // reads BBC_<run>.dat, BBC_A_<run>.dat and BBC_R_<run>.dat of <dir>
+  // into a record, applying the scales of the text tables
+  static int ReadTables(int run, TString dir, float *record);
+  // element of a record, for writers
+  static float& Recenter(float *record, int se, int ord, int xy, int bcen, int bvtx)
+  {return ((EPCell*) record)[bcen*EPCalib::kNVtx+bvtx].m[se][ord][xy];}
+  static float& FlatCos(float *record, int har, int ord, int bcen, int bvtx)
+  {return ((EPCell*) record)[bcen*EPCalib::kNVtx+bvtx].c[ord][har];}
+  static float& FlatSin(float *record, int har, int ord, int bcen, int bvtx)
+  {return ((EPCell*) record)[bcen*EPCalib::kNVtx+bvtx].s[ord][har];}
+
+  int Parts(int run) const {const float *r=Record(run); return r?fParts[(r-fData)/kNRecord]:0;}
+  const float* Record(int run) const {
+    if(run<fRunMin||run>fRunMax) return 0;
+    int rec = fIndex[run-fRunMin];
+    return rec<0 ? 0 : fData+(long)rec*kNRecord;
+  }
+  TString GetFileName() {return fFileName;}
+
+ private:
+  CalibStore();
+  ~CalibStore();
+  bool Map(TString file);
+
+  TString fFileName;
+  void *fMap;
+  long fSize;
+  long fTime; // modification time of the file
+  int fRunMin;
+  int fRunMax;
+  const int *fIndex;
+  const int *fParts;
+  const float *fData;
+};
+
+#endif
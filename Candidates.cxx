@@ -0,0 +1,34 @@
+#include <cmath>
+#include "Candidates.h"
+
+void Candidates::Clear() {
+  fMass.clear();
+  fPt.clear();
+  fPhi.clear();
+  fEta.clear();
+  fSector.clear();
+  fCuts.clear();
+}
+
+void Candidates::AddPxPyPzM(double px, double py, double pz, double m, int sector, unsigned int cuts) {
+  double pt = std::sqrt(px*px + py*py);
+  double eta;
+  if(pt>0) eta = std::asinh(pz/pt);
+  else eta = pz==0 ? 0 : pz>0 ? 10e10 : -10e10; // as TVector3::PseudoRapidity
+  AddPtEtaPhiM(pt, eta, std::atan2(py,px), m, sector, cuts);
+}
+
+void Candidates::AddPtEtaPhiM(double pt, double eta, double phi, double m, int sector, unsigned int cuts) {
+  fMass.push_back(m);
+  fPt.push_back(pt);
+  fPhi.push_back(phi);
+  fEta.push_back(eta);
+  fSector.push_back(sector);
+  fCuts.push_back(cuts);
+}
+
+TLorentzVector Candidates::Vector(unsigned int i) const {
+  TLorentzVector lv;
+  lv.SetPtEtaPhiM(fPt[i], fEta[i], fPhi[i], fMass[i]);
+  return lv;
+}
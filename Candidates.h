@@ -0,0 +1,40 @@
+#ifndef __CANDIDATES_HH__
+#define __CANDIDATES_HH__
+
+#include <vector>
+#include <TLorentzVector.h>
+
+// Particle candidates a producer task (AT_PiZero, AT_Charged) hands to
+// the tasks after it, one per event and slot. Kinematics are worked out
+// once when a candidate is added and kept as parallel arrays, so
+// consumers read plain floats. Each candidate carries the sector it was
+// built in (-1 if none) and its pass bits, bit i for cut set i (see
+// Analysis::GetCandidateCutNames). Producers also store candidates that
+// pass only a variation, so Cuts(i)&1 is the default selection: a
+// consumer that does not loop over the cut sets keeps only those.
+class Candidates {
+ public:
+  Candidates() {}
+  virtual ~Candidates() {}
+  void Clear();
+  void AddPxPyPzM(double px, double py, double pz, double m, int sector=-1, unsigned int cuts=1);
+  void AddPtEtaPhiM(double pt, double eta, double phi, double m, int sector=-1, unsigned int cuts=1);
+  unsigned int Size() const {return fPt.size();}
+  float Mass(unsigned int i) const {return fMass[i];}
+  float Pt(unsigned int i) const {return fPt[i];}
+  float Phi(unsigned int i) const {return fPhi[i];}
+  float Eta(unsigned int i) const {return fEta[i];}
+  int Sector(unsigned int i) const {return fSector[i];}
+  unsigned int Cuts(unsigned int i) const {return fCuts[i];}
+  TLorentzVector Vector(unsigned int i) const; // for code that wants one
+
+ private:
+  std::vector<float> fMass;
+  std::vector<float> fPt;
+  std::vector<float> fPhi;
+  std::vector<float> fEta;
+  std::vector<int> fSector;
+  std::vector<unsigned int> fCuts;
+};
+
+#endif
@@ -0,0 +1,141 @@
+#ifndef __EPCORRECTION_HH__
+#define __EPCORRECTION_HH__
+
+#include <iostream>
+#include <cmath>
+#include <TH1.h>
+#include "qcQ.h"
+#include "Harmonics.h"
+#include "HistoRegistry.h"
+
+// Recenter -> twist -> rescale of the sub-event Q vectors of one event,
+// and the flattening shift of their sum, for orders n=1..NORD.
+// CELL is the calibration cell of the detector (EPCell, MXCell, ...):
+// m[se][ord][xy] centroids of the orders 1,2,3,4,6,8 and c/s[ord][har]
+// flattening coefficients. Sub-events and orders are compile-time, so
+// the stages are straight loops over plain arrays.
+template<class CELL, int NSE, int NORD=4>
+class EPCorrection {
+ public:
+  static_assert(NORD<=4, "twisting needs the order 2n centroid");
+  enum {kPrime, kDoublePrime, kTriplePrime}; // stage after each step
+
+  void Load(int k, int j, qcQ &q) {
+    fX[k][j] = q.X();
+    fY[k][j] = q.Y();
+    fNP[k][j] = q.NP();
+    fM[k][j] = q.M();
+  }
+  void Load(int k, int j, double x, double y, double np, double m) {
+    fX[k][j] = x;
+    fY[k][j] = y;
+    fNP[k][j] = np;
+    fM[k][j] = m;
+  }
+  double X(int k, int j) const {return fX[k][j];}
+  double Y(int k, int j) const {return fY[k][j];}
+  // order k+1 goes with the Q vector
+  qcQ Sub(int k, int j) const {
+    qcQ q(k+1);
+    q.SetXY( fX[k][j], fY[k][j], fNP[k][j], fM[k][j] );
+    return q;
+  }
+  // sum of the sub-events
+  qcQ Full(int k) const {
+    qcQ q = Sub(k,0);
+    for(int j=1; j!=NSE; ++j) q = q + Sub(k,j);
+    return q;
+  }
+
+  void Recenter(const CELL &cell) {
+    for(int k=0; k!=NORD; ++k)
+      for(int j=0; j!=NSE; ++j) {
+	fX[k][j] -= cell.m[j][k][0];
+	fY[k][j] -= cell.m[j][k][1];
+      }
+  }
+  void Twist(const CELL &cell) {
+    for(int k=0; k!=NORD; ++k)
+      for(int j=0; j!=NSE; ++j) {
+	double c2n = cell.m[j][TwoN(k)][0] / fM[k][j];
+	double s2n = cell.m[j][TwoN(k)][1] / fM[k][j];
+	double ldaSm = s2n/(1.0+c2n);
+	double ldaSp = s2n/(1.0-c2n);
+	double den = 1.0 - ldaSm*ldaSp;
+	double x = fX[k][j];
+	double y = fY[k][j];
+	fX[k][j] = (x-ldaSm*y) / den;
+	fY[k][j] = (y-ldaSp*x) / den;
+      }
+  }
+  void Rescale(const CELL &cell) {
+    for(int k=0; k!=NORD; ++k)
+      for(int j=0; j!=NSE; ++j) {
+	double c2n = cell.m[j][TwoN(k)][0] / fM[k][j];
+	fX[k][j] /= 1.0+c2n;
+	fY[k][j] /= 1.0-c2n;
+      }
+  }
+  // all three steps; hook.Stage(step,*this) is called after each one
+  template<class HOOK> void Correct(const CELL &cell, HOOK &hook) {
+    Recenter(cell);
+    hook.Stage(kPrime,*this);
+    Twist(cell);
+    Check("twist");
+    hook.Stage(kDoublePrime,*this);
+    Rescale(cell);
+    Check("rescale");
+    hook.Stage(kTriplePrime,*this);
+  }
+  void Correct(const CELL &cell) {
+    NoHook hook;
+    Correct(cell,hook);
+  }
+  // shift of psi of order k+1 (2/n sum of the harmonics); cosn/sinn
+  // get cos(n psi) and sin(n psi)
+  static double Flatten(const CELL &cell, int k, double psi, double *cosn, double *sinn) {
+    double a[Harmonics::kN], b[Harmonics::kN];
+    Harmonics::CosSin(psi,cosn,sinn);
+    for(int ik=0; ik!=Harmonics::kN; ++ik) {
+      a[ik] = -cell.s[k][ik];
+      b[ik] = cell.c[k][ik];
+    }
+    return Harmonics::Series(cosn,sinn,a,b);
+  }
+
+  struct NoHook {
+    void Stage(int, const EPCorrection&) {}
+  };
+  // fills the QxC/QyC families (ord se cbin step) of a HistoRegistry
+  struct CentroidHook {
+    HistoRegistry *reg;
+    int famx;
+    int famy;
+    int bcen;
+    void Stage(int step, const EPCorrection &e) {
+      for(int j=0; j!=NSE; ++j)
+	for(int k=0; k!=NORD; ++k) {
+	  reg->Get(famx,k,j,bcen,step)->Fill( e.X(k,j) );
+	  reg->Get(famy,k,j,bcen,step)->Fill( e.Y(k,j) );
+	}
+    }
+  };
+
+ private:
+  // index of order 2n among 1,2,3,4,6,8
+  static int TwoN(int k) {return k==0 ? 1 : k+2;}
+  void Check(const char *step) const {
+    for(int k=0; k!=NORD; ++k)
+      for(int j=0; j!=NSE; ++j)
+	if( std::isnan(fX[k][j]) || std::isnan(fY[k][j]) )
+	  std::cout << "EPCorrection === NaN after " << step << " | order " << k+1
+		    << " | subevent " << j << " | qvec.M: " << fM[k][j] << std::endl;
+  }
+
+  double fX[NORD][NSE];
+  double fY[NORD][NSE];
+  double fNP[NORD][NSE];
+  double fM[NORD][NSE];
+};
+
+#endif
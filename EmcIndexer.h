@@ -4,6 +4,42 @@
 #include <vector>
 #include <string>
 
+// The tower table below is filled by the compiler where constexpr
+// constructors may loop (C++14), and at static initialisation otherwise.
+#if __cplusplus >= 201402L
+#define EMC_CONSTEXPR constexpr
+#else
+#define EMC_CONSTEXPR
+#endif
+
+/// What a TowerId decodes into, one entry per tower (0-24767).
+struct EmcTowerInfo {
+  unsigned char iS;      ///< sector (online, 0-7)
+  unsigned char x;       ///< x(SectorTower), zrow
+  unsigned char y;       ///< y(SectorTower), yrow
+  unsigned char armsect; ///< 4*arm + sector_in_arm (offline)
+};
+
+struct EmcTowerTable {
+  enum {kNTowers=24768};
+  EmcTowerInfo t[kNTowers];
+  EMC_CONSTEXPR EmcTowerTable() : t() {
+    for(int id=0; id!=kNTowers; ++id) {
+      int iS  = id<15552 ? id/2592 : 6+(id-15552)/4608;
+      int iST = id<15552 ? id%2592 : (id-15552)%4608;
+      int nx  = iS<6 ? 72 : 96;
+      int arm = iS<4 ? 0 : 1;
+      int sect = iS<4 ? iS : (iS-6<0 ? iS-6+4 : iS-6);
+      t[id].iS = iS;
+      t[id].x = iST%nx;
+      t[id].y = iST/nx;
+      t[id].armsect = 4*arm+sect;
+    }
+  }
+};
+
+extern const EmcTowerTable gEmcTowerTable;
+
 /** General EMCAL Indexer class.
     Primary source of conversion to/from various types of emcal indices,
     within various "frames" (whole emcal, one sector, one supermodule).
@@ -81,6 +117,25 @@ public:
       inside the Sector. */
   static void decodeTowerId(int TowerId, int & iS, int & x, int & y);
 
+  /**@name Table lookups of a TowerId (0-24767, not checked). */
+  //@{
+  static const EmcTowerInfo& Tower(int TowerId) { return gEmcTowerTable.t[TowerId]; }
+  static int TowerSector(int TowerId) { return Tower(TowerId).iS; }
+  static int TowerX(int TowerId) { return Tower(TowerId).x; }
+  static int TowerY(int TowerId) { return Tower(TowerId).y; }
+  static int TowerArm(int TowerId) { return Tower(TowerId).armsect>>2; }
+  static int TowerSectorInArm(int TowerId) { return Tower(TowerId).armsect&3; }
+  static bool TowerIsPbGl(int TowerId) { return Tower(TowerId).iS>5; }
+  static int TowerSoftwareKey(int TowerId) {
+    const EmcTowerInfo &t = Tower(TowerId);
+    return SoftwareKey(t.armsect>>2, t.armsect&3, t.y, t.x);
+  }
+  //@}
+
+  /// decodeTowerId of a whole vector of TowerIds (invalid ones give -1).
+  static void decodeTowerIds(const std::vector<int>& TowerIds, std::vector<int>& iS,
+			     std::vector<int>& x, std::vector<int>& y);
+
   /// Get (arm,sector_in_arm,yrow,zrow) from a TowerID (offline used).
   /// returns true for valid, false for invalid towerID.
   static bool TowerLocation(int towerID, int& arm, int& sector_in_arm,
@@ -100,7 +155,9 @@ public:
   /// Get (offline) softwareKey from TowerID.
   //  static long getSoftwareKey(int TowerId) 
   static int SoftwareKey(int TowerId);
-  static int SoftwareKey(int arm, int sector_in_arm, int yrow, int zrow);
+  static int SoftwareKey(int arm, int sector_in_arm, int yrow, int zrow) {
+    return 100000*arm + 10000*sector_in_arm + 100*yrow + zrow ;
+  }
 
   /// Tells if an absolute tower id is a PbSc reference.
   static bool isPbScReference(int TowerId);
@@ -245,10 +302,6 @@ public:
 
   //@}
 
-private:
-
-  static std::vector<std::string> fEmcSectorIdent;
-
 };
 
 #endif
@@ -0,0 +1,251 @@
+#include <vector>
+#include <TTree.h>
+#include <TString.h>
+#include "EventBuffers.h"
+
+template<class T>
+static void ConnectBranch(TTree *tree, const char *name, std::vector<T> *&ptr) {
+  if(!tree->GetBranchStatus(name)) return;
+  ptr = new std::vector<T>;
+  tree->SetBranchAddress(name,&ptr);
+}
+
+EventBuffers::EventBuffers() {
+  fGLB.vtxZ = fGLB.cent = fGLB.bbcs = fGLB.frac = 0;
+  fGLB.trig = 0;
+  fQCache = false;
+  fNSE[0] = fNSE[1] = fNSE[2] = 0;
+  pQ1ex = NULL;
+  pQ2ex = NULL;
+  pQ3ex = NULL;
+  pQ4ex = NULL;
+  pQ6ex = NULL;
+  pQ8ex = NULL;
+  pQ1fv = NULL;
+  pQ2fv = NULL;
+  pQ3fv = NULL;
+  pQ1bb = NULL;
+  pQ2bb = NULL;
+  pQ3bb = NULL;
+  pQ4bb = NULL;
+  pQ6bb = NULL;
+  pQ8bb = NULL;
+  pEMCid = NULL;
+  pEMCtwrid = NULL;
+  pEMCx = NULL;
+  pEMCy = NULL;
+  pEMCz = NULL;
+  pEMCecore = NULL;
+  pEMCecent = NULL;
+  pEMCchisq = NULL;
+  pEMCtimef = NULL;
+  pTRKqua = NULL;
+  pTRKpt = NULL;
+  pTRKphi = NULL;
+  pTRKpz = NULL;
+  pTRKecore = NULL;
+  pTRKetof = NULL;
+  pTRKtwrid = NULL;
+  pTRKplemc = NULL;
+  pTRKchisq = NULL;
+  pTRKdphi = NULL;
+  pTRKdz = NULL;
+  pTRKpc3sdphi = NULL;
+  pTRKpc3sdz = NULL;
+  pTRKzed = NULL;
+  pTRKdisp = NULL;
+  pTRKprob = NULL;
+  pTRKcid = NULL;
+  pMXSempccent = NULL;
+  pMXSempc3x3 = NULL;
+  pMXSpt = NULL;
+  pMXSpz = NULL;
+  pMXSeta = NULL;
+  pMXSphi = NULL;
+  pMXSflyr = NULL;
+  pMXSsingleD = NULL;
+  pMXSsingleP = NULL;
+}
+
+EventBuffers::~EventBuffers() {
+  if(pQ1ex) delete pQ1ex;
+  if(pQ2ex) delete pQ2ex;
+  if(pQ3ex) delete pQ3ex;
+  if(pQ4ex) delete pQ4ex;
+  if(pQ6ex) delete pQ6ex;
+  if(pQ8ex) delete pQ8ex;
+  if(pQ1fv) delete pQ1fv;
+  if(pQ2fv) delete pQ2fv;
+  if(pQ3fv) delete pQ3fv;
+  if(pQ1bb) delete pQ1bb;
+  if(pQ2bb) delete pQ2bb;
+  if(pQ3bb) delete pQ3bb;
+  if(pQ4bb) delete pQ4bb;
+  if(pQ6bb) delete pQ6bb;
+  if(pQ8bb) delete pQ8bb;
+  if(pEMCid) delete pEMCid;
+  if(pEMCtwrid) delete pEMCtwrid;
+  if(pEMCx) delete pEMCx;
+  if(pEMCy) delete pEMCy;
+  if(pEMCz) delete pEMCz;
+  if(pEMCecore) delete pEMCecore;
+  if(pEMCecent) delete pEMCecent;
+  if(pEMCchisq) delete pEMCchisq;
+  if(pEMCtimef) delete pEMCtimef;
+  if(pTRKqua) delete pTRKqua;
+  if(pTRKpt) delete pTRKpt;
+  if(pTRKphi) delete pTRKphi;
+  if(pTRKpz) delete pTRKpz;
+  if(pTRKecore) delete pTRKecore;
+  if(pTRKetof) delete pTRKetof;
+  if(pTRKtwrid) delete pTRKtwrid;
+  if(pTRKplemc) delete pTRKplemc;
+  if(pTRKchisq) delete pTRKchisq;
+  if(pTRKdphi) delete pTRKdphi;
+  if(pTRKdz) delete pTRKdz;
+  if(pTRKpc3sdphi) delete pTRKpc3sdphi;
+  if(pTRKpc3sdz) delete pTRKpc3sdz;
+  if(pTRKzed) delete pTRKzed;
+  if(pTRKdisp) delete pTRKdisp;
+  if(pTRKprob) delete pTRKprob;
+  if(pTRKcid) delete pTRKcid;
+  if(pMXSempccent) delete pMXSempccent;
+  if(pMXSempc3x3) delete pMXSempc3x3;
+  if(pMXSpt) delete pMXSpt;
+  if(pMXSpz) delete pMXSpz;
+  if(pMXSeta) delete pMXSeta;
+  if(pMXSphi) delete pMXSphi;
+  if(pMXSflyr) delete pMXSflyr;
+  if(pMXSsingleD) delete pMXSsingleD;
+  if(pMXSsingleP) delete pMXSsingleP;
+}
+
+void EventBuffers::Connect(TTree *tree) {
+  tree->SetBranchAddress("Event",&fGLB);
+  //=
+  if(tree->GetBranch("nbb")) {
+    fQCache = true;
+    for(int i=0; i!=3; ++i)
+      tree->SetBranchAddress(QCounter(i*6),&fNSE[i]);
+    for(int i=0; i!=kNQ; ++i) {
+      if(!tree->GetBranchStatus(QName(i))) continue;
+      QVector(i) = new std::vector<qcQ>;
+      tree->SetBranchAddress(QName(i),fFlat[i]);
+    }
+    return; // nothing else in there
+  }
+  ConnectBranch(tree,"Q1ex",pQ1ex);
+  ConnectBranch(tree,"Q2ex",pQ2ex);
+  ConnectBranch(tree,"Q3ex",pQ3ex);
+  ConnectBranch(tree,"Q4ex",pQ4ex);
+  ConnectBranch(tree,"Q6ex",pQ6ex);
+  ConnectBranch(tree,"Q8ex",pQ8ex);
+  ConnectBranch(tree,"Q1fv",pQ1fv);
+  ConnectBranch(tree,"Q2fv",pQ2fv);
+  ConnectBranch(tree,"Q3fv",pQ3fv);
+  ConnectBranch(tree,"Q1bb",pQ1bb);
+  ConnectBranch(tree,"Q2bb",pQ2bb);
+  ConnectBranch(tree,"Q3bb",pQ3bb);
+  ConnectBranch(tree,"Q4bb",pQ4bb);
+  ConnectBranch(tree,"Q6bb",pQ6bb);
+  ConnectBranch(tree,"Q8bb",pQ8bb);
+  //=
+  ConnectBranch(tree,"EMCid",   pEMCid);
+  ConnectBranch(tree,"EMCtwrid",pEMCtwrid);
+  ConnectBranch(tree,"EMCx",    pEMCx);
+  ConnectBranch(tree,"EMCy",    pEMCy);
+  ConnectBranch(tree,"EMCz",    pEMCz);
+  ConnectBranch(tree,"EMCecore",pEMCecore);
+  ConnectBranch(tree,"EMCecent",pEMCecent);
+  ConnectBranch(tree,"EMCchisq",pEMCchisq);
+  ConnectBranch(tree,"EMCtimef",pEMCtimef);
+  //=
+  ConnectBranch(tree,"TRKqua",  pTRKqua);
+  ConnectBranch(tree,"TRKpt",   pTRKpt);
+  ConnectBranch(tree,"TRKphi",  pTRKphi);
+  ConnectBranch(tree,"TRKpz",   pTRKpz);
+  ConnectBranch(tree,"TRKecore",pTRKecore);
+  ConnectBranch(tree,"TRKetof", pTRKetof);
+  ConnectBranch(tree,"TRKplemc",pTRKplemc);
+  ConnectBranch(tree,"TRKtwrid",pTRKtwrid);
+  ConnectBranch(tree,"TRKchisq",pTRKchisq);
+  ConnectBranch(tree,"TRKdphi", pTRKdphi);
+  ConnectBranch(tree,"TRKdz",   pTRKdz);
+  ConnectBranch(tree,"TRKpc3sdphi",pTRKpc3sdphi);
+  ConnectBranch(tree,"TRKpc3sdz",  pTRKpc3sdz);
+  ConnectBranch(tree,"TRKzed",  pTRKzed);
+  ConnectBranch(tree,"TRKdisp", pTRKdisp);
+  ConnectBranch(tree,"TRKprob", pTRKprob);
+  ConnectBranch(tree,"TRKcid",  pTRKcid);
+  //=
+  ConnectBranch(tree,"MXSpt",  pMXSpt);
+  ConnectBranch(tree,"MXSpz",  pMXSpz);
+  ConnectBranch(tree,"MXSphi", pMXSphi);
+  ConnectBranch(tree,"MXSflyr",pMXSflyr);
+  ConnectBranch(tree,"MXSsingleD", pMXSsingleD);
+  ConnectBranch(tree,"MXSsingleP", pMXSsingleP);
+  ConnectBranch(tree,"MXSempccent",pMXSempccent);
+  ConnectBranch(tree,"MXSempc3x3", pMXSempc3x3);
+}
+
+const char* EventBuffers::QName(int i) {
+  static const char *names[kNQ] = {"Q1ex","Q2ex","Q3ex","Q4ex","Q6ex","Q8ex",
+				   "Q1fv","Q2fv","Q3fv",
+				   "Q1bb","Q2bb","Q3bb","Q4bb","Q6bb","Q8bb"};
+  return names[i];
+}
+
+int EventBuffers::QOrder(int i) {
+  static const int orders[kNQ] = {1,2,3,4,6,8, 1,2,3, 1,2,3,4,6,8};
+  return orders[i];
+}
+
+const char* EventBuffers::QCounter(int i) {
+  return i<6 ? "nex" : i<9 ? "nfv" : "nbb";
+}
+
+std::vector<qcQ>*& EventBuffers::QVector(int i) {
+  std::vector<qcQ> **ptr[kNQ] = {&pQ1ex,&pQ2ex,&pQ3ex,&pQ4ex,&pQ6ex,&pQ8ex,
+				 &pQ1fv,&pQ2fv,&pQ3fv,
+				 &pQ1bb,&pQ2bb,&pQ3bb,&pQ4bb,&pQ6bb,&pQ8bb};
+  return *ptr[i];
+}
+
+void EventBuffers::BranchQCache(TTree *tree, const char *leaflist) {
+  tree->Branch("Event",&fGLB,leaflist);
+  for(int i=0; i!=3; ++i)
+    tree->Branch(QCounter(i*6),&fNSE[i],Form("%s/I",QCounter(i*6)));
+  for(int i=0; i!=kNQ; ++i)
+    tree->Branch(QName(i),fFlat[i],Form("%s[%s][4]/F",QName(i),QCounter(i)));
+}
+
+void EventBuffers::Pack() {
+  fNSE[0] = fNSE[1] = fNSE[2] = 0;
+  for(int i=0; i!=kNQ; ++i) {
+    std::vector<qcQ> *q = QVector(i);
+    if(!q) continue;
+    int g = i<6 ? 0 : i<9 ? 1 : 2;
+    int n = (int)q->size()<kMaxSE ? (int)q->size() : kMaxSE;
+    if(n>fNSE[g]) fNSE[g] = n;
+    for(int j=0; j!=n; ++j) {
+      fFlat[i][j][0] = q->at(j).X();
+      fFlat[i][j][1] = q->at(j).Y();
+      fFlat[i][j][2] = q->at(j).M();
+      fFlat[i][j][3] = q->at(j).NP();
+    }
+    for(int j=n; j<kMaxSE; ++j)
+      fFlat[i][j][0] = fFlat[i][j][1] = fFlat[i][j][2] = fFlat[i][j][3] = 0;
+  }
+}
+
+void EventBuffers::Unpack() {
+  if(!fQCache) return;
+  for(int i=0; i!=kNQ; ++i) {
+    std::vector<qcQ> *q = QVector(i);
+    if(!q) continue;
+    int n = fNSE[ i<6 ? 0 : i<9 ? 1 : 2 ];
+    q->assign(n,qcQ(QOrder(i)));
+    for(int j=0; j!=n; ++j)
+      q->at(j).SetXY( fFlat[i][j][0], fFlat[i][j][1], fFlat[i][j][3], fFlat[i][j][2] );
+  }
+}
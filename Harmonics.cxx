@@ -0,0 +1,68 @@
+#include <TProfile2D.h>
+#include <TArrayD.h>
+#include "Harmonics.h"
+
+FlatteningSums::FlatteningSums() {
+  fNcen = 0;
+  fNvtx = 0;
+}
+
+FlatteningSums::~FlatteningSums() {
+  for(uint i=0; i!=fBlocks.size(); ++i)
+    if(fBlocks[i]) delete [] fBlocks[i];
+}
+
+void FlatteningSums::Init(int nord, int ncen, int nvtx) {
+  fNcen = ncen;
+  fNvtx = nvtx;
+  fBlocks.assign(nord*ncen,(double*)NULL);
+}
+
+double* FlatteningSums::NewBlock() {
+  int n = fNvtx*kStride;
+  double *blk = new double[n];
+  for(int i=0; i!=n; ++i) blk[i] = 0;
+  return blk;
+}
+
+void FlatteningSums::Export(int ord, int cen, TProfile2D *pc, TProfile2D *ps) {
+  const double *blk = fBlocks[ord*fNcen+cen];
+  if(!blk) return;
+  Export(blk,1,pc);
+  Export(blk,1+2*Harmonics::kN,ps);
+}
+
+void FlatteningSums::Export(const double *blk, int off, TProfile2D *p) {
+  // the same bins and statistics unit-weight Fill(vtx,n,z) would leave
+  p->Reset();
+  TArrayD *sumw2 = p->GetSumw2();
+  TArrayD *binsumw2 = p->GetBinSumw2();
+  double stats[9] = {0,0,0,0,0,0,0,0,0};
+  for(int v=0; v!=fNvtx; ++v) {
+    const double *b = blk + v*kStride;
+    double nent = b[0];
+    if(nent==0) continue;
+    double x = p->GetXaxis()->GetBinCenter(v+1);
+    for(int i=0; i!=Harmonics::kN; ++i) {
+      double y = i+1;
+      double z = b[off+i];
+      double z2 = b[off+Harmonics::kN+i];
+      int bin = p->GetBin(v+1,i+1);
+      p->SetBinEntries(bin,nent);
+      p->SetBinContent(bin,z);
+      sumw2->fArray[bin] = z2;
+      if(binsumw2->fN>0) binsumw2->fArray[bin] = nent;
+      stats[0] += nent;
+      stats[1] += nent;
+      stats[2] += nent*x;
+      stats[3] += nent*x*x;
+      stats[4] += nent*y;
+      stats[5] += nent*y*y;
+      stats[6] += nent*x*y;
+      stats[7] += z;
+      stats[8] += z2;
+    }
+  }
+  p->PutStats(stats);
+  p->SetEntries(stats[0]);
+}
@@ -0,0 +1,71 @@
+#ifndef __HARMONICS_HH__
+#define __HARMONICS_HH__
+
+#include <vector>
+#include <cmath>
+
+class TProfile2D;
+
+// cos(n psi) and sin(n psi), n=1..32, as used by the event-plane
+// flattening, from a single sin/cos and the angle-addition recurrence
+// (the rounding error grows like n*eps, far below the table precision).
+namespace Harmonics {
+  const int kN = 32;
+  inline void CosSin(double psi, double *c, double *s) {
+    double c1 = std::cos(psi);
+    double s1 = std::sin(psi);
+    c[0] = c1;
+    s[0] = s1;
+    for(int i=1; i!=kN; ++i) {
+      c[i] = c[i-1]*c1 - s[i-1]*s1;
+      s[i] = s[i-1]*c1 + c[i-1]*s1;
+    }
+  }
+  // sum_n 2/n ( a_n cos(n psi) + b_n sin(n psi) )
+  inline double Series(const double *c, const double *s, const double *a, const double *b) {
+    double ret = 0;
+    for(int i=0; i!=kN; ++i)
+      ret += (a[i]*c[i] + b[i]*s[i])*2.0/(i+1);
+    return ret;
+  }
+}
+
+// <cos(n psi)> and <sin(n psi)> per (order, centrality, vertex, n),
+// summed in dense blocks instead of 2x32 TProfile2D::Fill per event.
+// A block is allocated for an (order, centrality) on its first event;
+// Export turns it into the PsiC/PsiS profiles the tables are made from.
+class FlatteningSums {
+ public:
+  FlatteningSums();
+  virtual ~FlatteningSums();
+  void Init(int nord, int ncen, int nvtx);
+  void Fill(int ord, int cen, int vtx, const double *c, const double *s) {
+    double *&blk = fBlocks[ord*fNcen+cen];
+    if(!blk) blk = NewBlock();
+    double *b = blk + vtx*kStride;
+    b[0] += 1;
+    double *bc = b+1;
+    double *bc2 = bc+Harmonics::kN;
+    double *bs = bc2+Harmonics::kN;
+    double *bs2 = bs+Harmonics::kN;
+    for(int i=0; i!=Harmonics::kN; ++i) {
+      bc[i] += c[i];
+      bc2[i] += c[i]*c[i];
+      bs[i] += s[i];
+      bs2[i] += s[i]*s[i];
+    }
+  }
+  bool Filled(int ord, int cen) {return fBlocks[ord*fNcen+cen]!=NULL;}
+  // replaces the content of the profiles (x: vertex bin, y: n)
+  void Export(int ord, int cen, TProfile2D *pc, TProfile2D *ps);
+
+ private:
+  enum {kStride = 1+4*Harmonics::kN}; // entries, cos, cos2, sin, sin2
+  double* NewBlock();
+  void Export(const double *blk, int off, TProfile2D *p);
+  int fNcen;
+  int fNvtx;
+  std::vector<double*> fBlocks;
+};
+
+#endif
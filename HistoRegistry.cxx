@@ -0,0 +1,46 @@
+#include <TH1.h>
+#include "HistoRegistry.h"
+
+HistoRegistry::~HistoRegistry() {
+  for(uint fam=0; fam!=fFamilies.size(); ++fam) {
+    delete fFamilies[fam].proto;
+    for(uint i=0; i!=fHistos[fam].size(); ++i)
+      if(fHistos[fam][i]) delete fHistos[fam][i];
+  }
+}
+
+int HistoRegistry::Add(TH1 *proto, const char *pattern, int n0, int n1, int n2, int n3, int off0) {
+  proto->SetDirectory(0);
+  Family f;
+  f.proto = proto;
+  f.pattern = pattern;
+  f.n[0] = n0;
+  f.n[1] = n1;
+  f.n[2] = n2;
+  f.n[3] = n3;
+  f.off0 = off0;
+  fFamilies.push_back( f );
+  fHistos.push_back( std::vector<TH1*>(n0*n1*n2*n3,(TH1*)NULL) );
+  return fFamilies.size()-1;
+}
+
+TH1* HistoRegistry::Make(int fam, int i0, int i1, int i2, int i3) {
+  const Family &f = fFamilies[fam];
+  TH1 *h = (TH1*) f.proto->Clone( Form(f.pattern.Data(),i0+f.off0,i1,i2,i3) );
+  h->SetDirectory(0);
+  return h;
+}
+
+void HistoRegistry::Write() {
+  for(uint fam=0; fam!=fHistos.size(); ++fam)
+    for(uint i=0; i!=fHistos[fam].size(); ++i)
+      if(fHistos[fam][i]) fHistos[fam][i]->Write();
+}
+
+int HistoRegistry::Booked() {
+  int ret = 0;
+  for(uint fam=0; fam!=fHistos.size(); ++fam)
+    for(uint i=0; i!=fHistos[fam].size(); ++i)
+      if(fHistos[fam][i]) ++ret;
+  return ret;
+}
@@ -0,0 +1,44 @@
+#ifndef __HISTOREGISTRY_HH__
+#define __HISTOREGISTRY_HH__
+
+#include <vector>
+#include <TString.h>
+
+class TH1;
+
+// Families of identically binned histograms indexed by up to four
+// integers. A histogram is cloned from the family prototype the first
+// time its index is asked for, and only those are written, so memory and
+// output follow the bins (centrality, order, ...) the data populate.
+// Families are added in Init; a registry is copied only while empty.
+class HistoRegistry {
+ public:
+  HistoRegistry() {}
+  virtual ~HistoRegistry();
+  // adopts the prototype; the name is a Form() pattern of the indices,
+  // the first one printed as i0+off0 (e.g. harmonic k stored as k+1)
+  int Add(TH1 *proto, const char *pattern, int n0, int n1=1, int n2=1, int n3=1, int off0=0);
+  TH1* Get(int fam, int i0, int i1=0, int i2=0, int i3=0) {
+    const Family &f = fFamilies[fam];
+    TH1 *&h = fHistos[fam][((i0*f.n[1]+i1)*f.n[2]+i2)*f.n[3]+i3];
+    if(!h) h = Make(fam,i0,i1,i2,i3);
+    return h;
+  }
+  // only the booked ones, in index order
+  void Write();
+  int Booked();
+
+ private:
+  struct Family {
+    TH1 *proto;
+    TString pattern;
+    int n[4];
+    int off0;
+  };
+  TH1* Make(int fam, int i0, int i1, int i2, int i3);
+
+  std::vector<Family> fFamilies;
+  std::vector< std::vector<TH1*> > fHistos;
+};
+
+#endif
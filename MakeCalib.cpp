@@ -0,0 +1,90 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <TString.h>
+#include <TFile.h>
+#include <TH2F.h>
+#include <TH1D.h>
+#include <TProfile2D.h>
+#include <TSystem.h>
+#include "CalibStore.h"
+
+// Builds the binary calibration store read by AT_ReadTree::LoadTableEP.
+//
+//  Run_MakeCalib <runs.dat> [store] [tables]
+//
+// Recentering and flattening coefficients are taken at full precision
+// from BBC_EPC/out/run<run>.root (as qcent.C and coef.C do) when it is
+// there, otherwise from the text tables; resolutions come from the
+// BBC_R tables written by res.C.
+
+TString gTables = "BBC_EPC/tables";
+
+int FillFromHistos(int run, float *record) {
+  TString name = Form("BBC_EPC/out/run%d.root",run);
+  if(gSystem->AccessPathName(name)) return 0;
+  TFile *file = new TFile( name );
+  char xy[2] = {'x','y'};
+  for(int se=0; se!=2; ++se) {
+    for(int ord=0; ord!=6; ++ord) {
+      for(int ix=0; ix!=2; ++ix) {
+	for(int i=0; i!=60; ++i) {
+	  TH2F *QH = (TH2F*) file->Get( Form("BBCQ%d%c_S%d_CB%02d",ord+1,xy[ix],se,i) );
+	  if(!QH) continue; // never filled: zeros
+	  for(int j=0; j!=40 && j!=QH->GetXaxis()->GetNbins(); ++j) {
+	    TH1D *h = QH->ProjectionY( Form("%s_P%d",QH->GetName(),j), j+1, j+1 );
+	    if(h->GetEntries()>=100)
+	      CalibStore::Recenter(record,se,ord,ix,i,j) = h->GetMean();
+	    delete h;
+	  }
+	}
+      }
+    }
+  }
+  for(int ord=0; ord!=4; ++ord) {
+    for(int i=0; i!=60; ++i) {
+      TProfile2D *QC = (TProfile2D*) file->Get( Form("BBCPsiC_Ord%d_Cen%02d",ord,i) );
+      TProfile2D *QS = (TProfile2D*) file->Get( Form("BBCPsiS_Ord%d_Cen%02d",ord,i) );
+      for(int in=0; in!=32; ++in) {
+	for(int j=0; j!=40; ++j) {
+	  if(QC) CalibStore::FlatCos(record,in,ord,i,j) = QC->GetBinContent( j+1, in+1 );
+	  if(QS) CalibStore::FlatSin(record,in,ord,i,j) = QS->GetBinContent( j+1, in+1 );
+	}
+      }
+    }
+  }
+  file->Close();
+  delete file;
+  return CalibStore::kRecenter | CalibStore::kFlat;
+}
+
+int Fill(int run, float *record) {
+  int parts = CalibStore::ReadTables(run,gTables,record);
+  int hparts = FillFromHistos(run,record);
+  parts |= hparts;
+  std::cout << " RUN " << run << (hparts?" histograms":" tables");
+  std::cout << (parts&CalibStore::kRecenter?" recenter":"");
+  std::cout << (parts&CalibStore::kFlat?" flattening":"");
+  std::cout << (parts&CalibStore::kRes?" resolution":"") << std::endl;
+  return parts;
+}
+
+int main(int argc, char *argv[]){
+  if(argc<2) {
+    std::cout << "usage: Run_MakeCalib <runs.dat> [store] [tables]" << std::endl;
+    return 1;
+  }
+  TString store = argc>2 ? argv[2] : "BBC_EPC/tables/calib.bin";
+  if(argc>3) gTables = argv[3];
+  std::vector<int> runs;
+  std::ifstream fin( argv[1] );
+  int run;
+  for(;;) {
+    fin >> run;
+    if(!fin.good()) break;
+    runs.push_back(run);
+  }
+  fin.close();
+  std::cout << "Run_MakeCalib: " << runs.size() << " runs into " << store.Data() << std::endl;
+  if(!CalibStore::Create(store,runs,Fill)) return 1;
+}
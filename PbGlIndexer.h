@@ -46,10 +46,6 @@ class PbGlIndexer : public EmcIndexer
  protected:
  PbGlIndexer();
   virtual ~PbGlIndexer();
-
- private:
-  static PbGlIndexer * single;
-  static int access_count;
 };
 
 #endif
@@ -42,10 +42,6 @@ class PbScIndexer : public EmcIndexer
  protected:
  PbScIndexer();
  virtual ~PbScIndexer();
-
- private:
-  static PbScIndexer * single;
-  static int access_count;
 };
 //extern PbScIndexer    * gPbSc;
 #endif
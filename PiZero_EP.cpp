@@ -11,6 +11,8 @@ int main(int argc, char *argv[]){
   TString snev = argv[2];
   int nev = snev.Atoi();
   TString spar3 = argv[3];
+  int nth = 1;
+  if(argc>4) nth = TString(argv[4]).Atoi();
 
   unsigned int trigger_BBCLL1narrowcent  = 0x00000008;
   unsigned int trigger_BBCLL1narrow      = 0x00000010;
@@ -54,13 +56,37 @@ int main(int argc, char *argv[]){
     tsk->SetTime(6.0); ssys="FT1";
   } else if(spar3.Contains("T1")) {
     tsk->SetTime(5.5); ssys="T1";
+  } else if(spar3.Contains("SYS")) {
+    // all variations in one pass, written in directories of the nominal output
+    tsk->AddVariation("D0", 7.5,0.80,5.0);
+    tsk->AddVariation("D1", 8.5,0.80,5.0);
+    tsk->AddVariation("A0", 8.0,0.75,5.0);
+    tsk->AddVariation("A1", 8.0,0.85,5.0);
+    tsk->AddVariation("T0", 8.0,0.80,4.5);
+    tsk->AddVariation("T1", 8.0,0.80,5.5);
+    tsk->AddVariation("FD0",7.0,0.80,5.0);
+    tsk->AddVariation("FD1",9.0,0.80,5.0);
+    tsk->AddVariation("FA0",8.0,0.65,5.0);
+    tsk->AddVariation("FA1",8.0,0.90,5.0);
+    tsk->AddVariation("FT0",8.0,0.80,4.0);
+    tsk->AddVariation("FT1",8.0,0.80,6.0);
   }
 
   Analysis *ana = Analysis::Instance();
-  ana->InputFileName( Form("trees%s/%s.root",sert.Data(),run.Data()) );
+  if(run.EndsWith(".dat")) {
+    // list of segments chained in one job
+    ana->InputFileList( run, Form("trees%s/%%s.root",sert.Data()) );
+    run = Analysis::TagOfFile( run );
+    run.ReplaceAll(".dat","");
+  } else {
+    ana->InputFileName( Form("trees%s/%s.root",sert.Data(),run.Data()) );
+    ana->DataSetTag( run );
+  }
   ana->OutputFileName( Form("PiZero_EP/out%s%s/out_%s.root",sert.Data(),ssys.Data(),run.Data()) );
-  ana->DataSetTag( run );
+  ana->Checkpoint( Form("PiZero_EP/out%s%s/ckpt_%s.root",sert.Data(),ssys.Data(),run.Data()), 200000 );
   ana->NumberOfEventsToAnalyze( nev );
+  ana->NumberOfThreads( nth );
+  ana->ReadCacheSize( 50*1024*1024 );
   ana->AddTask( tsk );
 
   AT_EP *tsk2 = new AT_EP();
@@ -0,0 +1,61 @@
+#ifndef __QCUMULANT_HH__
+#define __QCUMULANT_HH__
+
+#include "qcQ.h"
+
+// Event averages of multi-particle azimuthal correlations from Q
+// vectors (Bilandzic, Snellings, Voloshin, PRC 83 044913), unit
+// weights. Q vectors are qcQ with X,Y = sum cos,sin(n phi) and M the
+// multiplicity. The differential ones take p (particles of interest
+// in a bin) and q (those also used for Q): here every particle of
+// interest is one of the reference, so q = p. Each returns the
+// average and sets w to its event weight (0: not defined for the
+// event).
+class QCumulant {
+ public:
+  // <2> = <cos n(phi1-phi2)>
+  static double Two(qcQ &Qn, double &w) {
+    double M = Qn.M();
+    w = M*(M-1);
+    if(w<=0) return 0;
+    return (Qn.X()*Qn.X() + Qn.Y()*Qn.Y() - M) / w;
+  }
+  // <4> = <cos n(phi1+phi2-phi3-phi4)>
+  static double Four(qcQ &Qn, qcQ &Q2n, double &w) {
+    double M = Qn.M();
+    w = M*(M-1)*(M-2)*(M-3);
+    if(w<=0) return 0;
+    double x = Qn.X(), y = Qn.Y(), x2 = Q2n.X(), y2 = Q2n.Y();
+    double qn2 = x*x + y*y;
+    // Re[Q2n Qn* Qn*]
+    double re = x2*(x*x-y*y) + y2*(2*x*y);
+    return ( qn2*qn2 + x2*x2 + y2*y2 - 2*re
+	     - 4*(M-2)*qn2 + 2*M*(M-3) ) / w;
+  }
+  // <2'> = <cos n(psi1-phi2)>
+  static double TwoPrime(qcQ &pn, qcQ &Qn, double &w) {
+    double M = Qn.M(), mp = pn.M(), mq = mp;
+    w = mp*M - mq;
+    if(w<=0) return 0;
+    return (pn.X()*Qn.X() + pn.Y()*Qn.Y() - mq) / w;
+  }
+  // <4'> = <cos n(psi1+phi2-phi3-phi4)>
+  static double FourPrime(qcQ &pn, qcQ &p2n, qcQ &Qn, qcQ &Q2n, double &w) {
+    double M = Qn.M(), mp = pn.M(), mq = mp;
+    w = (mp*M - 3*mq)*(M-1)*(M-2);
+    if(w<=0) return 0;
+    double px = pn.X(), py = pn.Y(), p2x = p2n.X(), p2y = p2n.Y();
+    double x = Qn.X(), y = Qn.Y(), x2 = Q2n.X(), y2 = Q2n.Y();
+    double qn2 = x*x + y*y;
+    double pQ = px*x + py*y;                // Re[pn Qn*]
+    double rQ = x*x - y*y, iQ = 2*x*y;      // Qn Qn
+    double q2QQ = p2x*rQ + p2y*iQ;          // Re[q2n Qn* Qn*]
+    double pQQ2 = (px*x - py*y)*x2 + (px*y + py*x)*y2; // Re[pn Qn Q2n*]
+    double q2Q2 = p2x*x2 + p2y*y2;          // Re[q2n Q2n*]
+    // Re[pn Qn Qn* Qn*] = |Qn|^2 Re[pn Qn*]; Re[Qn qn*] = Re[qn Qn*]
+    return ( qn2*pQ - q2QQ - pQQ2 - 2*M*pQ - 2*mq*qn2
+	     + 7*pQ - pQ + q2Q2 + 2*pQ + 2*mq*M - 6*mq ) / w;
+  }
+};
+
+#endif
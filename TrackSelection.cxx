@@ -0,0 +1,56 @@
+#include <cmath>
+#include "EventBuffers.h"
+#include "TrackSelection.h"
+
+TrackSelection::TrackSelection(EventBuffers *event) {
+  fEvent = event;
+  fDone = false;
+  CUTS ref;
+  ref.quality = 63;
+  ref.zedMin = 3;
+  ref.zedMax = 70;
+  ref.pc3dphi = 3;
+  ref.pc3dz = 3;
+  AddCuts(ref);
+}
+
+int TrackSelection::AddCuts(const CUTS &cuts) {
+  for(unsigned int s=0; s!=fCuts.size(); ++s) {
+    const CUTS &c = fCuts[s];
+    if(c.quality==cuts.quality && c.zedMin==cuts.zedMin && c.zedMax==cuts.zedMax &&
+       c.pc3dphi==cuts.pc3dphi && c.pc3dz==cuts.pc3dz) return s;
+  }
+  if(fCuts.size()==32) return -1;
+  fCuts.push_back(cuts);
+  fSelected.resize(fCuts.size());
+  fDone = false;
+  return fCuts.size()-1;
+}
+
+void TrackSelection::Select() {
+  fDone = true;
+  for(unsigned int s=0; s!=fSelected.size(); ++s) fSelected[s].clear();
+  int n = 0;
+  if(fEvent->pTRKqua && fEvent->pTRKzed && fEvent->pTRKpc3sdphi && fEvent->pTRKpc3sdz)
+    n = fEvent->pTRKqua->size();
+  fMask.assign(n,0u);
+  if(n==0) return;
+  const int *qua = &(*fEvent->pTRKqua)[0];
+  const float *zed = &(*fEvent->pTRKzed)[0];
+  const float *dphi = &(*fEvent->pTRKpc3sdphi)[0];
+  const float *dz = &(*fEvent->pTRKpc3sdz)[0];
+  unsigned int *mask = &fMask[0];
+  // one branch-free pass over the columns per set
+  for(unsigned int s=0; s!=fCuts.size(); ++s) {
+    const CUTS c = fCuts[s];
+    for(int i=0; i<n; ++i) {
+      float az = std::fabs(zed[i]);
+      unsigned int pass = (qua[i]==c.quality) & (az>=c.zedMin) & (az<=c.zedMax) &
+	(std::fabs(dphi[i])<=c.pc3dphi) & (std::fabs(dz[i])<=c.pc3dz);
+      mask[i] |= pass<<s;
+    }
+  }
+  for(int i=0; i!=n; ++i)
+    for(unsigned int s=0; s!=fCuts.size(); ++s)
+      if( (mask[i]>>s)&1 ) fSelected[s].push_back(i);
+}
@@ -0,0 +1,41 @@
+#ifndef __TRACKSELECTION_HH__
+#define __TRACKSELECTION_HH__
+
+#include <vector>
+
+class EventBuffers;
+
+// Track cuts of the charged-hadron tasks, evaluated once per event for
+// every task of the event loop. Each cut set has a bit in Mask(i) and a
+// list of the passing track indices; set 0 is the reference selection
+// (ReferenceTracks). The first task asking in an event pays for it.
+class TrackSelection {
+ public:
+  struct CUTS {
+    int quality;   // TRKqua
+    float zedMin;  // |TRKzed|
+    float zedMax;
+    float pc3dphi; // |TRKpc3sdphi|
+    float pc3dz;   // |TRKpc3sdz|
+  };
+  TrackSelection(EventBuffers *event);
+  virtual ~TrackSelection() {}
+  // bit of the set (an identical set is shared), -1 if all 32 are taken;
+  // sets are added in Init
+  int AddCuts(const CUTS &cuts);
+  void NewEvent() {fDone=false;} // called by Analysis after GetEntry
+  unsigned int Mask(unsigned int itrk) {Evaluate(); return fMask[itrk];}
+  const std::vector<unsigned int>& Selected(int set=0) {Evaluate(); return fSelected[set];}
+
+ private:
+  void Evaluate() {if(!fDone) Select();}
+  void Select();
+
+  EventBuffers *fEvent;
+  bool fDone;
+  std::vector<CUTS> fCuts;
+  std::vector<unsigned int> fMask; // [track]
+  std::vector< std::vector<unsigned int> > fSelected; // [set]
+};
+
+#endif
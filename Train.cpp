@@ -0,0 +1,224 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstdlib>
+#include <TString.h>
+#include <TObjArray.h>
+#include <TObjString.h>
+#include "Analysis.h"
+#include "AT_ReadTree.h"
+#include "AT_BBC_EPC.h"
+#include "AT_BBC_Calib.h"
+#include "AT_MX_EPC.h"
+#include "AT_PiZero.h"
+#include "AT_PiZeroFlow.h"
+#include "AT_EP.h"
+#include "AT_Charged.h"
+#include "AT_QC.h"
+#include "AT_PIDFlow.h"
+#include "AT_Skim.h"
+#include "AT_QCache.h"
+
+// Runs every task listed in a config file over one read of the input.
+//
+//  Run_Train <config> [input] [nev]
+//
+// Config, one keyword per line ('#' starts a comment):
+//  input   <file.root | list.dat | RUN_SEGMENT>
+//  pattern trees/%s.root            (expands RUN_SEGMENT entries)
+//  output  train/out_%s.root        (%s is the data set tag)
+//  events  -1
+//  threads 1
+//  cache   52428800
+//  checkpoint train/ckpt_%s.root 200000
+//  qcache                           (inputs are AT_QCache files)
+//  task <class> [dir=NAME] [trigger=0x18] [cent=0,5] [skipbbcqcal]
+//               [calib=BBC_EPC/tables/calib.bin]
+//               [qa] [pt=0.8,22] [dist=8] [alpha=0.8] [time=5]
+//               [variation=NAME,dist,alpha,time] [mix=5,5,6]
+//               [file=skim/%s.root] [compress=404] [keep=EMC*,TRKpt]
+//               [tables=BBC_EPC/tables] [spill=.]
+// Tasks run in the order they are listed, so consumers of candidates
+// (AT_EP, AT_QC) have to follow their producer (AT_PiZero, AT_Charged).
+
+AnalysisTask* MakeTask(TString cls) {
+  if(cls=="AT_ReadTree") return new AT_ReadTree();
+  if(cls=="AT_BBC_EPC") return new AT_BBC_EPC();
+  if(cls=="AT_BBC_Calib") return new AT_BBC_Calib();
+  if(cls=="AT_MX_EPC") return new AT_MX_EPC();
+  if(cls=="AT_PiZero") return new AT_PiZero();
+  if(cls=="AT_PiZeroFlow") return new AT_PiZeroFlow();
+  if(cls=="AT_EP") return new AT_EP();
+  if(cls=="AT_Charged") return new AT_Charged();
+  if(cls=="AT_QC") return new AT_QC();
+  if(cls=="AT_PIDFlow") return new AT_PIDFlow();
+  if(cls=="AT_Skim") return new AT_Skim();
+  if(cls=="AT_QCache") return new AT_QCache();
+  return NULL;
+}
+
+bool Configure(AnalysisTask *tsk, TString opt) {
+  TString key = opt;
+  TString val = "";
+  int eq = opt.Index("=");
+  if(eq>=0) {
+    key = opt(0,eq);
+    val = opt(eq+1,opt.Length());
+  }
+  TObjArray *arr = val.Tokenize(",");
+  int nval = arr->GetEntries();
+  float v[4] = {0,0,0,0};
+  for(int i=0; i<nval && i<4; ++i)
+    v[i] = ((TObjString*) arr->At(i))->GetString().Atof();
+  TString first = nval>0 ? ((TObjString*) arr->At(0))->GetString() : TString("");
+  delete arr;
+  AT_ReadTree *rt = dynamic_cast<AT_ReadTree*>(tsk);
+  AT_PiZero *pi0 = dynamic_cast<AT_PiZero*>(tsk);
+  AT_Skim *skm = dynamic_cast<AT_Skim*>(tsk);
+  AT_QCache *qch = dynamic_cast<AT_QCache*>(tsk);
+  AT_BBC_Calib *cal = dynamic_cast<AT_BBC_Calib*>(tsk);
+  if(key=="dir") {
+    tsk->OutputDirectory(val);
+  } else if(key=="trigger" && rt) {
+    rt->TriggerMask( strtoul(val.Data(),NULL,0) );
+  } else if(key=="cent" && rt && nval==2) {
+    rt->CentralitySelection(v[0],v[1]);
+  } else if(key=="skipbbcqcal" && rt) {
+    rt->SkipBBCQCal();
+  } else if(key=="calib" && rt) {
+    rt->CalibrationStore(val);
+  } else if(key=="qa" && pi0) {
+    pi0->DoQA();
+  } else if(key=="pt" && pi0 && nval==2) {
+    pi0->SetPt(v[0],v[1]);
+  } else if(key=="dist" && pi0) {
+    pi0->SetDist(v[0]);
+  } else if(key=="alpha" && pi0) {
+    pi0->SetAlpha(v[0]);
+  } else if(key=="time" && pi0) {
+    pi0->SetTime(v[0]);
+  } else if(key=="variation" && pi0 && nval==4) {
+    // first token is the name, the other three the cut values
+    pi0->AddVariation(first,v[1],v[2],v[3]);
+  } else if(key=="mix" && pi0 && nval>=1) {
+    // depth[,centrality bins[,psi2 bins]]
+    pi0->SetMixing(int(v[0]), nval>1?int(v[1]):1, nval>2?int(v[2]):1);
+  } else if(key=="file" && skm) {
+    skm->SkimFileName( val );
+  } else if(key=="compress" && skm) {
+    skm->Compression( val.Atoi() );
+  } else if(key=="file" && qch) {
+    qch->CacheFileName( val );
+  } else if(key=="compress" && qch) {
+    qch->Compression( val.Atoi() );
+  } else if(key=="keep" && skm) {
+    TObjArray *tok = val.Tokenize(",");
+    for(int i=0; i!=tok->GetEntries(); ++i)
+      skm->KeepBranch( ((TObjString*) tok->At(i))->GetString() );
+    delete tok;
+  } else if(key=="tables" && cal) {
+    cal->TableDirectory( val );
+  } else if(key=="spill" && cal) {
+    cal->SpillDirectory( val );
+  } else {
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]){
+  if(argc<2) {
+    std::cout << "usage: Run_Train <config> [input] [nev]" << std::endl;
+    return 1;
+  }
+  TString input = "";
+  TString pattern = "trees/%s.root";
+  TString output = "train/out_%s.root";
+  Long64_t nev = -1;
+  int nth = 1;
+  Long64_t cache = 50*1024*1024;
+  TString ckpt = "";
+  Long64_t ckptevery = 0;
+
+  Analysis *ana = Analysis::Instance();
+  std::ifstream fin( argv[1] );
+  if(!fin.good()) {
+    std::cout << "Run_Train: cannot open " << argv[1] << std::endl;
+    return 1;
+  }
+  std::string sline;
+  int nline = 0;
+  int ntsk = 0;
+  while(std::getline(fin,sline)) {
+    ++nline;
+    TString line = sline.c_str();
+    if(line.Index("#")>=0) line.Remove(line.Index("#"));
+    TObjArray *arr = line.Tokenize(" \t");
+    int ntok = arr->GetEntries();
+    if(ntok==0) {
+      delete arr;
+      continue;
+    }
+    TString key = ((TObjString*) arr->At(0))->GetString();
+    TString val = ntok>1 ? ((TObjString*) arr->At(1))->GetString() : TString("");
+    bool ok = true;
+    if(key=="input") input = val;
+    else if(key=="pattern") pattern = val;
+    else if(key=="output") output = val;
+    else if(key=="events") nev = val.Atoll();
+    else if(key=="threads") nth = val.Atoi();
+    else if(key=="cache") cache = val.Atoll();
+    else if(key=="qcache") ana->QCacheInput();
+    else if(key=="checkpoint") {
+      ckpt = val;
+      ckptevery = ntok>2 ? ((TObjString*) arr->At(2))->GetString().Atoll() : 100000;
+    }
+    else if(key=="task") {
+      AnalysisTask *tsk = MakeTask(val);
+      ok = (tsk!=NULL);
+      for(int i=2; ok && i<ntok; ++i) {
+	TString opt = ((TObjString*) arr->At(i))->GetString();
+	ok = Configure(tsk,opt);
+	if(!ok) std::cout << "Run_Train: option " << opt.Data() << " not valid for " << val.Data() << std::endl;
+      }
+      if(ok) {
+	ana->AddTask( tsk );
+	++ntsk;
+      } else if(tsk) {
+	delete tsk;
+      }
+    } else ok = false;
+    delete arr;
+    if(!ok) {
+      std::cout << "Run_Train: cannot understand line " << nline << ": " << sline << std::endl;
+      return 1;
+    }
+  }
+  fin.close();
+  if(argc>2) input = argv[2];
+  if(argc>3) nev = TString(argv[3]).Atoll();
+  if(ntsk==0 || input.Length()==0) {
+    std::cout << "Run_Train: nothing to do (no task or no input)" << std::endl;
+    return 1;
+  }
+
+  TString tag;
+  if(input.EndsWith(".dat")) {
+    // list of segments chained in one job
+    ana->InputFileList( input, pattern );
+    tag = Analysis::TagOfFile( input );
+    tag.ReplaceAll(".dat","");
+  } else {
+    if(!input.EndsWith(".root")) input = Form(pattern.Data(),input.Data());
+    ana->InputFileName( input );
+    tag = Analysis::TagOfFile( input );
+    ana->DataSetTag( tag );
+  }
+  ana->OutputFileName( Form(output.Data(),tag.Data()) );
+  ana->NumberOfEventsToAnalyze( nev );
+  ana->NumberOfThreads( nth );
+  ana->ReadCacheSize( cache );
+  if(ckpt.Length()>0) ana->Checkpoint( Form(ckpt.Data(),tag.Data()), ckptevery );
+
+  ana->Run();
+}